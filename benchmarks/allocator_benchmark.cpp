@@ -0,0 +1,122 @@
+#include "allocators.h"
+#include "benchmark_utils.h"
+#include "open_addressing_hash_table.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Random lookups in a table much larger than the TLB reach, with the slot
+// arrays from std::allocator, HugePageAllocator and an Arena. Reports ns per
+// lookup and, where perf events are readable (perf_event_paranoid <= 2 and
+// not in a restricted container), data-TLB misses per lookup; -1 otherwise.
+//
+// Usage: AllocatorBenchmark [elements] [lookups]
+
+// Counts data-TLB read misses of this thread while alive.
+class TlbMissCounter {
+public:
+  TlbMissCounter() {
+#ifdef __linux__
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+  ~TlbMissCounter() {
+#ifdef __linux__
+    if (fd >= 0)
+      close(fd);
+#endif
+  }
+
+  // Misses so far, or -1 if the counter could not be opened.
+  long long read() const {
+#ifdef __linux__
+    long long count;
+    if (fd >= 0 && ::read(fd, &count, sizeof(count)) == sizeof(count))
+      return count;
+#endif
+    return -1;
+  }
+
+private:
+  int fd = -1;
+};
+
+template <typename Table>
+void run(const char *name, Table &table, size_t elements, size_t lookups) {
+  std::vector<int> keys = random_int_keys(elements, 42);
+
+  // Presized, so every allocator serves a single slot array.
+  size_t capacity = 4;
+  while (capacity * LOAD_FACTOR < elements + 1)
+    capacity *= 2;
+
+  Stopwatch insert_watch;
+  table.rehash(capacity);
+  for (int key : keys)
+    table.insert(key, key);
+  double insert_ms = insert_watch.elapsed_ms();
+
+  uint64_t seed = 7;
+  size_t found = 0;
+  TlbMissCounter misses;
+  Stopwatch find_watch;
+  for (size_t i = 0; i < lookups; ++i)
+    found += table.contains(keys[next_random(seed) % elements]);
+  double find_ms = find_watch.elapsed_ms();
+  long long tlb_misses = misses.read();
+  do_not_optimize(found);
+
+  std::printf("%s,%zu,%.2f,%.2f,%.3f\n", name, elements,
+              insert_ms * 1e6 / elements, find_ms * 1e6 / lookups,
+              tlb_misses < 0 ? -1.0 : double(tlb_misses) / lookups);
+  std::fflush(stdout);
+}
+
+template <typename Allocator>
+using IntTable =
+    OpenAddressingHashTable<int, int, Hash<int>, LinearHashing<int>, Allocator>;
+
+int main(int argc, char **argv) {
+  size_t elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 24;
+  size_t lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1 << 24;
+
+  std::printf("allocator,elements,insert_ns,find_ns,dtlb_misses_per_find\n");
+  {
+    IntTable<std::allocator<Entry<int, int>>> table;
+    run("std_allocator", table, elements, lookups);
+  }
+#ifdef __linux__
+  {
+    IntTable<HugePageAllocator<Entry<int, int>>> table;
+    run("huge_page", table, elements, lookups);
+  }
+#endif
+  {
+    Arena arena(size_t(1) << 20);
+    IntTable<ArenaAllocator<Entry<int, int>>> table{
+        ArenaAllocator<Entry<int, int>>(arena)};
+    run("arena", table, elements, lookups);
+  }
+  return 0;
+}
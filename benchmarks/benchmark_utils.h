@@ -0,0 +1,40 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Minimal self-contained timing helpers shared by the benchmark executables.
+
+class Stopwatch {
+public:
+  Stopwatch() : start(std::chrono::steady_clock::now()) {}
+  double elapsed_ms() const {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  }
+
+private:
+  std::chrono::steady_clock::time_point start;
+};
+
+// Keeps the optimizer from dropping a computed value.
+template <typename T> inline void do_not_optimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// splitmix64: fast, deterministic key generator.
+inline uint64_t next_random(uint64_t &state) {
+  uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+inline std::vector<int> random_int_keys(size_t count, uint64_t seed) {
+  std::vector<int> keys(count);
+  for (auto &key : keys)
+    key = static_cast<int>(next_random(seed));
+  return keys;
+}
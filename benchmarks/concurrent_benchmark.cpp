@@ -0,0 +1,100 @@
+#include "benchmark_utils.h"
+#include "concurrent_hash_table.h"
+#include "lock_free_hash_table.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+// Throughput of a read-mostly mixed workload (90% find, 10% insert) for one
+// OpenAddressingHashTable behind a single mutex, the sharded
+// ConcurrentOpenAddressingHashTable and LockFreeHashTable, for 1..max_threads
+// threads.
+//
+// Usage: ConcurrentHashTableBenchmark [max_threads] [ops_per_thread]
+
+constexpr size_t KEY_SPACE = 1 << 20;
+
+class GlobalLockTable {
+public:
+  bool insert(int key, int value) {
+    std::lock_guard<std::mutex> guard(lock);
+    return table.insert(key, value).second;
+  }
+  bool contains(int key) {
+    std::lock_guard<std::mutex> guard(lock);
+    return table.contains(key);
+  }
+
+private:
+  std::mutex lock;
+  OpenAddressingHashTable<int, int, Hash<int>> table;
+};
+
+template <typename Table>
+double run(Table &table, unsigned threads, size_t ops_per_thread) {
+  std::vector<std::thread> workers;
+  std::atomic<bool> go{false};
+  std::atomic<size_t> found{0};
+
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      uint64_t seed = 12345 + t;
+      size_t hits = 0;
+      while (!go.load(std::memory_order_acquire))
+        std::this_thread::yield();
+      for (size_t i = 0; i < ops_per_thread; ++i) {
+        uint64_t r = next_random(seed);
+        int key = static_cast<int>(r % KEY_SPACE);
+        if (r >> 60 == 0)
+          table.insert(key, key);
+        else
+          hits += table.contains(key);
+      }
+      found += hits;
+    });
+  }
+
+  Stopwatch watch;
+  go.store(true, std::memory_order_release);
+  for (auto &worker : workers)
+    worker.join();
+  double ms = watch.elapsed_ms();
+  do_not_optimize(found.load());
+  return threads * ops_per_thread / ms / 1000.0;
+}
+
+template <typename Table> void prefill(Table &table) {
+  for (size_t key = 0; key < KEY_SPACE; key += 2)
+    table.insert(static_cast<int>(key), static_cast<int>(key));
+}
+
+int main(int argc, char **argv) {
+  unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+  if (argc > 1)
+    max_threads = std::atoi(argv[1]);
+  size_t ops = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+
+  std::vector<unsigned> thread_counts;
+  for (unsigned threads = 1; threads < max_threads; threads *= 2)
+    thread_counts.push_back(threads);
+  thread_counts.push_back(max_threads);
+
+  std::printf("threads,global_lock_mops,sharded_mops,lock_free_mops\n");
+  for (unsigned threads : thread_counts) {
+    GlobalLockTable global;
+    ConcurrentOpenAddressingHashTable<int, int, Hash<int>> sharded;
+    LockFreeHashTable<int, int, Hash<int>> lock_free;
+    prefill(global);
+    prefill(sharded);
+    prefill(lock_free);
+
+    double global_mops = run(global, threads, ops);
+    double sharded_mops = run(sharded, threads, ops);
+    double lock_free_mops = run(lock_free, threads, ops);
+    std::printf("%u,%.2f,%.2f,%.2f\n", threads, global_mops, sharded_mops,
+                lock_free_mops);
+  }
+  return 0;
+}
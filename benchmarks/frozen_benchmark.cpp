@@ -0,0 +1,83 @@
+#include "benchmark_utils.h"
+#include "open_addressing_hash_table.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// A read-only dictionary served by OpenAddressingHashTable and by its
+// freeze()d FrozenHashTable. Lookups take present keys in random order
+// (find_hit) and absent keys (find_miss).
+//
+//   build_ns   freeze() per key (the table is already filled)
+//   bytes      slot arrays per key: entries and control bytes for the
+//              table, entries and pilots for the frozen one
+//
+// Usage: FrozenBenchmark [max_size]
+//
+// Prints CSV: table,key,size,build_ns,find_hit,find_miss,bytes
+
+template <typename Key> Key make_key(uint64_t &seed);
+template <> int make_key<int>(uint64_t &seed) {
+  return static_cast<int>(next_random(seed));
+}
+template <> std::string make_key<std::string>(uint64_t &seed) {
+  return "word:" + std::to_string(next_random(seed) % 100000000);
+}
+
+template <typename Table, typename Key>
+double lookup_ns(const Table &table, const std::vector<Key> &keys) {
+  size_t found = 0;
+  Stopwatch watch;
+  for (const Key &key : keys)
+    found += table.contains(key);
+  double ms = watch.elapsed_ms();
+  do_not_optimize(found);
+  return ms * 1e6 / keys.size();
+}
+
+template <typename Key>
+void run(const char *key_name, size_t n) {
+  uint64_t seed = n;
+  OpenAddressingHashTable<Key, int, Hash<Key>> table;
+  std::vector<Key> present;
+  while (table.size() < n) {
+    Key key = make_key<Key>(seed);
+    if (table.insert(key, static_cast<int>(table.size())).second)
+      present.push_back(key);
+  }
+  std::vector<Key> hits;
+  for (size_t i = 0; i < n; ++i)
+    hits.push_back(present[next_random(seed) % n]);
+  std::vector<Key> misses;
+  while (misses.size() < n) {
+    Key key = make_key<Key>(seed);
+    if (!table.contains(key))
+      misses.push_back(key);
+  }
+
+  Stopwatch build;
+  auto frozen = table.freeze();
+  double build_ms = build.elapsed_ms();
+
+  std::printf("linear,%s,%zu,0,%.2f,%.2f,%.1f\n", key_name, n,
+              lookup_ns(table, hits), lookup_ns(table, misses),
+              double(table.bucket_count() *
+                     (sizeof(Entry<Key, int>) + sizeof(ctrl_t))) /
+                  n);
+  std::printf("frozen,%s,%zu,%.1f,%.2f,%.2f,%.1f\n", key_name, n,
+              build_ms * 1e6 / n, lookup_ns(frozen, hits),
+              lookup_ns(frozen, misses), double(frozen.memory_bytes()) / n);
+  std::fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+  size_t max_size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 3 << 20;
+
+  std::printf("table,key,size,build_ns,find_hit,find_miss,bytes\n");
+  for (size_t n = 3 << 8; n <= max_size; n *= 16) {
+    run<int>("int", n);
+    run<std::string>("string", n);
+  }
+  return 0;
+}
@@ -0,0 +1,227 @@
+#include "accelerated_hash.h"
+#include "benchmark_utils.h"
+#include "open_addressing_hash_table.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Hash quality report for the built-in hash functions, each combined with
+// every index mix, over key sets shaped like real ones. All metrics are taken
+// on the slot index, i.e. the low bits of mix(hash), at the capacity a table
+// holding the keys at LOAD_FACTOR would have:
+//
+//   avalanche_worst  max over index bits of |2 P(bit flips) - 1| when one
+//                    key bit is flipped: 0 is ideal, 1 means a bit that
+//                    never (or always) reacts
+//   avalanche_mean   the same, averaged over index bits
+//   occupancy_var    variance of keys per home slot over its mean; about 1
+//                    for a uniform hash, far above 1 when keys pile up
+//   probe_mean, probe_p99, probe_max
+//                    slots visited per insert with linear probing
+//
+// Usage: HashAnalyzer [keys] [filter]
+//   keys    keys per set (default 65536)
+//   filter  only run hashes or key sets whose name contains this string
+//
+// Prints CSV:
+// hash,keys,mix,capacity,avalanche_worst,avalanche_mean,occupancy_var,
+// probe_mean,probe_p99,probe_max
+
+constexpr size_t AVALANCHE_SAMPLES = 1000;
+
+// Copies of key that differ from it in exactly one bit.
+std::vector<int> bit_flips(int key) {
+  std::vector<int> flips;
+  for (int bit = 0; bit < 32; ++bit)
+    flips.push_back(key ^ static_cast<int>(1u << bit));
+  return flips;
+}
+std::vector<char> bit_flips(char key) {
+  std::vector<char> flips;
+  for (int bit = 0; bit < 8; ++bit)
+    flips.push_back(static_cast<char>(key ^ (1 << bit)));
+  return flips;
+}
+std::vector<float> bit_flips(float key) {
+  uint32_t bits;
+  std::memcpy(&bits, &key, sizeof(bits));
+  std::vector<float> flips;
+  for (int bit = 0; bit < 32; ++bit) {
+    uint32_t flipped = bits ^ (1u << bit);
+    float value;
+    std::memcpy(&value, &flipped, sizeof(value));
+    flips.push_back(value);
+  }
+  return flips;
+}
+std::vector<std::string> bit_flips(const std::string &key) {
+  std::vector<std::string> flips;
+  for (size_t i = 0; i < key.size(); ++i) {
+    for (int bit = 0; bit < 8; ++bit) {
+      flips.push_back(key);
+      flips.back()[i] ^= static_cast<char>(1 << bit);
+    }
+  }
+  return flips;
+}
+
+template <typename Key, typename HashFunction, typename Mix>
+void analyze(const char *hash_name, const char *keys_name,
+             const char *mix_name, const std::vector<Key> &keys) {
+  HashFunction hasher;
+  Mix mix;
+  size_t capacity = 4;
+  while (capacity * LOAD_FACTOR < keys.size() + 1)
+    capacity *= 2;
+  const size_t mask = capacity - 1;
+  int index_bits = 0;
+  while ((size_t(1) << index_bits) < capacity)
+    ++index_bits;
+
+  std::vector<size_t> flipped(index_bits, 0);
+  size_t trials = 0;
+  size_t stride = std::max<size_t>(1, keys.size() / AVALANCHE_SAMPLES);
+  for (size_t k = 0; k < keys.size(); k += stride) {
+    size_t index = mix(hasher(keys[k])) & mask;
+    for (const Key &other : bit_flips(keys[k])) {
+      size_t changed = index ^ (mix(hasher(other)) & mask);
+      for (int bit = 0; bit < index_bits; ++bit)
+        flipped[bit] += (changed >> bit) & 1;
+      ++trials;
+    }
+  }
+  double worst = 0, mean = 0;
+  for (size_t count : flipped) {
+    double bias = std::fabs(2.0 * count / trials - 1.0);
+    worst = std::max(worst, bias);
+    mean += bias / index_bits;
+  }
+
+  std::vector<uint32_t> home(capacity, 0);
+  for (const Key &key : keys)
+    ++home[mix(hasher(key)) & mask];
+  double load = double(keys.size()) / capacity, variance = 0;
+  for (uint32_t count : home)
+    variance += (count - load) * (count - load) / capacity;
+
+  LinearHashing<Key, Mix> probe;
+  std::vector<bool> used(capacity, false);
+  std::vector<size_t> probes;
+  probes.reserve(keys.size());
+  for (const Key &key : keys) {
+    size_t hash = hasher(key), i = 0;
+    while (used[probe(hash, i, capacity)])
+      ++i;
+    used[probe(hash, i, capacity)] = true;
+    probes.push_back(i + 1);
+  }
+  std::sort(probes.begin(), probes.end());
+  double probe_mean = 0;
+  for (size_t count : probes)
+    probe_mean += double(count) / probes.size();
+
+  std::printf("%s,%s,%s,%zu,%.3f,%.3f,%.2f,%.2f,%zu,%zu\n", hash_name,
+              keys_name, mix_name, capacity, worst, mean, variance / load,
+              probe_mean, probes[probes.size() * 99 / 100], probes.back());
+  std::fflush(stdout);
+}
+
+template <typename Key, typename HashFunction>
+void analyze_mixes(const char *hash_name, const char *keys_name,
+                   const std::vector<Key> &keys, const char *filter) {
+  if (filter && !std::strstr(hash_name, filter) &&
+      !std::strstr(keys_name, filter))
+    return;
+  analyze<Key, HashFunction, IdentityMix>(hash_name, keys_name, "identity",
+                                          keys);
+  analyze<Key, HashFunction, FibonacciMix>(hash_name, keys_name, "fibonacci",
+                                           keys);
+  analyze<Key, HashFunction, FinalizerMix>(hash_name, keys_name, "finalizer",
+                                           keys);
+}
+
+template <typename Key, typename Make>
+std::vector<Key> make_keys(size_t count, Make make) {
+  std::vector<Key> keys;
+  keys.reserve(count);
+  for (size_t i = 0; i < count; ++i)
+    keys.push_back(make(i));
+  return keys;
+}
+
+std::string random_string(uint64_t &seed, size_t min_size, size_t max_size) {
+  std::string key(min_size + next_random(seed) % (max_size - min_size + 1),
+                  '\0');
+  for (char &c : key)
+    c = static_cast<char>('a' + next_random(seed) % 26);
+  return key;
+}
+
+int main(int argc, char **argv) {
+  size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 16;
+  const char *filter = argc > 2 ? argv[2] : nullptr;
+  uint64_t seed = 42;
+
+  std::printf("hash,keys,mix,capacity,avalanche_worst,avalanche_mean,"
+              "occupancy_var,probe_mean,probe_p99,probe_max\n");
+
+  analyze_mixes<int, Hash<int>>(
+      "int", "sequential", make_keys<int>(n, [](size_t i) { return int(i); }),
+      filter);
+  analyze_mixes<int, Hash<int>>(
+      "int", "stride_10",
+      make_keys<int>(n, [](size_t i) { return int(i * 10); }), filter);
+  analyze_mixes<int, Hash<int>>(
+      "int", "stride_4096",
+      make_keys<int>(n, [](size_t i) { return int(i << 12); }), filter);
+  analyze_mixes<int, Hash<int>>("int", "random",
+                                random_int_keys(n, seed), filter);
+
+  std::vector<char> chars;
+  for (int c = -128; c < 128; ++c)
+    chars.push_back(static_cast<char>(c));
+  analyze_mixes<char, Hash<char>>("char", "all", chars, filter);
+
+  analyze_mixes<float, Hash<float>>(
+      "float", "integers",
+      make_keys<float>(n, [](size_t i) { return float(i); }), filter);
+  analyze_mixes<float, Hash<float>>(
+      "float", "tenths",
+      make_keys<float>(n, [](size_t i) { return i * 0.1f; }), filter);
+  analyze_mixes<float, Hash<float>>(
+      "float", "unit_random", make_keys<float>(n, [&seed](size_t) {
+        return float(next_random(seed) >> 40) / float(1 << 24);
+      }),
+      filter);
+
+  std::vector<std::pair<const char *, std::vector<std::string>>> strings = {
+      {"counter", make_keys<std::string>(
+                      n, [](size_t i) { return "key_" + std::to_string(i); })},
+      {"url", make_keys<std::string>(n,
+                                     [](size_t i) {
+                                       return "https://example.com/users/" +
+                                              std::to_string(i * 7919) +
+                                              "/profile?tab=activity";
+                                     })},
+      {"path", make_keys<std::string>(n,
+                                      [](size_t i) {
+                                        return "/var/log/service/" +
+                                               std::to_string(i % 31) +
+                                               "/part-" + std::to_string(i) +
+                                               ".log";
+                                      })},
+      {"random", make_keys<std::string>(n, [&seed](size_t) {
+         return random_string(seed, 8, 40);
+       })}};
+  for (const auto &[name, keys] : strings) {
+    analyze_mixes<std::string, Hash<std::string>>("string", name, keys,
+                                                  filter);
+    analyze_mixes<std::string, AcceleratedStringHash>("string_accelerated",
+                                                      name, keys, filter);
+  }
+  return 0;
+}
@@ -0,0 +1,323 @@
+#include "benchmark_utils.h"
+#include "compact_string_hash_table.h"
+#include "cuckoo_hash_table.h"
+#include "open_addressing_hash_table.h"
+#include "robin_hood_hash_table.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+// Single-threaded wall-clock comparison of the probing policies, the Robin
+// Hood table and std::unordered_map. Every table runs the same workloads on
+// the same keys:
+//
+//   insert     n inserts into an empty table (growth included)
+//   bulk_load  the same keys loaded presized, where offered: bulk_insert
+//              for our tables, reserve + range insert for unordered_map
+//   find_hit   n lookups of present keys, in shuffled order
+//   find_miss  n lookups of absent keys
+//   find_batch the find_hit lookups through contains_batch, where offered
+//   erase      n erases of present keys
+//   mixed      n operations on a full table: 80% hits, 10% insert, 10% erase
+//
+// Small tables are rebuilt and rerun until about MIN_OPS operations were
+// timed, so every row is averaged over enough work to be stable.
+//
+// The linear_ml50, linear_ml875 and linear_x1_5 tables are linear probing
+// with max_load_factor 0.5 and 0.875 and with OneAndHalfGrowth; compare
+// their bytes_per_key (slot arrays after the inserts, divided by the number
+// of keys; 0 where unknown) with their timings against plain linear.
+// linear_telemetry is plain linear with a HashTableTelemetry attached at
+// its default sampling, to show what always-on telemetry costs.
+// compact_string (string keys only) is CompactStringHashTable; its
+// bytes_per_key includes the key arena, while the std::string tables'
+// leave out the heap blocks of keys too long for SSO.
+// cuckoo and cuckoo_8 are CuckooHashTable with 4- and 8-slot buckets: every
+// find reads two buckets at most, paid for by displacement on insert.
+//
+// Usage: HashTableBenchmarks [max_size] [filter]
+//   max_size  largest table, in elements (default 3M, far beyond LLC)
+//   filter    only run tables whose name contains this string
+//
+// Prints CSV: table,key,size,workload,ns_per_op,bytes_per_key
+
+constexpr size_t MIN_OPS = size_t(1) << 21;
+
+// A bijection on 32-bit values, so keys derived from distinct indices are
+// distinct: [0, n) gives the present keys and [n, 2n) the absent ones.
+inline uint32_t scramble(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7FEB352DU;
+  x ^= x >> 15;
+  x *= 0x846CA68BU;
+  x ^= x >> 16;
+  return x;
+}
+
+template <typename Key> Key make_key(uint32_t index);
+template <> int make_key<int>(uint32_t index) {
+  return static_cast<int>(scramble(index));
+}
+template <> std::string make_key<std::string>(uint32_t index) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "user:%08x:profile", scramble(index));
+  return buffer;
+}
+
+template <typename Key> std::vector<Key> make_keys(size_t first, size_t count) {
+  std::vector<Key> keys;
+  keys.reserve(count);
+  for (size_t i = 0; i < count; ++i)
+    keys.push_back(make_key<Key>(static_cast<uint32_t>(first + i)));
+  return keys;
+}
+
+template <typename T> void shuffle(std::vector<T> &items, uint64_t seed) {
+  for (size_t i = items.size(); i > 1; --i)
+    std::swap(items[i - 1], items[next_random(seed) % i]);
+}
+
+// The tables disagree on insert's signature; everything else is uniform.
+template <typename Table, typename Key>
+void insert(Table &table, const Key &key, int value) {
+  table.insert(key, value);
+}
+template <typename Key>
+void insert(std::unordered_map<Key, int> &table, const Key &key, int value) {
+  table.emplace(key, value);
+}
+
+template <typename Table, typename = void>
+struct has_batch_lookup : std::false_type {};
+template <typename Table>
+struct has_batch_lookup<Table, std::void_t<decltype(&Table::contains_batch)>>
+    : std::true_type {};
+
+template <typename Table, typename = void>
+struct has_bulk_load : std::false_type {};
+template <typename Table>
+struct has_bulk_load<Table, std::void_t<decltype(&Table::reserve)>>
+    : std::true_type {};
+
+template <typename Table, typename Pairs>
+void bulk_load(Table &table, const Pairs &pairs) {
+  table.bulk_insert(pairs.begin(), pairs.end());
+}
+template <typename Key, typename Pairs>
+void bulk_load(std::unordered_map<Key, int> &table, const Pairs &pairs) {
+  table.reserve(pairs.size());
+  table.insert(pairs.begin(), pairs.end());
+}
+
+// A table constructed with a different max_load_factor, in thousandths.
+template <typename Table, int MaxLoadPerMille> struct WithMaxLoad : Table {
+  WithMaxLoad() { this->max_load_factor(MaxLoadPerMille / 1000.0f); }
+};
+
+template <typename Table> struct WithTelemetry : Table {
+  HashTableTelemetry telemetry;
+  WithTelemetry() { this->set_telemetry(&telemetry); }
+};
+
+template <typename Table> size_t slot_bytes(const Table &) { return 0; }
+template <typename K, typename V, typename H, typename P, typename A,
+          typename G>
+size_t slot_bytes(const OpenAddressingHashTable<K, V, H, P, A, G> &table) {
+  return table.bucket_count() *
+         (sizeof(Entry<K, V>) + sizeof(ctrl_t) +
+          (stores_hash<H>::value ? sizeof(size_t) : 0));
+}
+template <typename Table, int MaxLoadPerMille>
+size_t slot_bytes(const WithMaxLoad<Table, MaxLoadPerMille> &table) {
+  return slot_bytes(static_cast<const Table &>(table));
+}
+template <typename Table>
+size_t slot_bytes(const WithTelemetry<Table> &table) {
+  return slot_bytes(static_cast<const Table &>(table));
+}
+template <typename V, typename H, typename P>
+size_t slot_bytes(const CompactStringHashTable<V, H, P> &table) {
+  return table.memory_bytes();
+}
+
+template <typename K, typename V, typename H, size_t B>
+size_t slot_bytes(const CuckooHashTable<K, V, H, B> &table) {
+  return table.buckets.size() *
+         sizeof(typename CuckooHashTable<K, V, H, B>::Bucket);
+}
+
+template <typename Key> struct Workload {
+  std::vector<Key> present;
+  std::vector<Key> lookups;
+  std::vector<Key> missing;
+  std::vector<std::pair<Key, int>> pairs;
+};
+
+template <typename Key> Workload<Key> make_workload(size_t n) {
+  Workload<Key> workload;
+  workload.present = make_keys<Key>(0, n);
+  workload.lookups = workload.present;
+  shuffle(workload.lookups, n);
+  workload.missing = make_keys<Key>(n, n);
+  for (size_t i = 0; i < n; ++i)
+    workload.pairs.emplace_back(workload.present[i], static_cast<int>(i));
+  return workload;
+}
+
+template <typename Table, typename Key>
+void fill(Table &table, const std::vector<Key> &keys) {
+  for (size_t i = 0; i < keys.size(); ++i)
+    insert(table, keys[i], static_cast<int>(i));
+}
+
+template <typename Table, typename Key>
+void run_table(const char *table_name, const char *key_name,
+               const Workload<Key> &workload) {
+  const size_t n = workload.present.size();
+  const size_t rounds = std::max<size_t>(1, MIN_OPS / n);
+  double insert_ms = 0, hit_ms = 0, miss_ms = 0, erase_ms = 0, mixed_ms = 0;
+  double batch_ms = 0, bulk_ms = 0;
+  size_t bytes = 0;
+  std::unique_ptr<bool[]> results(new bool[n]);
+
+  for (size_t round = 0; round < rounds; ++round) {
+    Table table;
+    Stopwatch insert_watch;
+    fill(table, workload.present);
+    insert_ms += insert_watch.elapsed_ms();
+    bytes = slot_bytes(table);
+
+    if constexpr (has_bulk_load<Table>::value) {
+      Table loaded;
+      Stopwatch bulk_watch;
+      bulk_load(loaded, workload.pairs);
+      bulk_ms += bulk_watch.elapsed_ms();
+    }
+
+    size_t found = 0;
+    Stopwatch hit_watch;
+    for (const Key &key : workload.lookups)
+      found += table.find(key) != table.end();
+    hit_ms += hit_watch.elapsed_ms();
+
+    Stopwatch miss_watch;
+    for (const Key &key : workload.missing)
+      found += table.find(key) != table.end();
+    miss_ms += miss_watch.elapsed_ms();
+    do_not_optimize(found);
+
+    if constexpr (has_batch_lookup<Table>::value) {
+      Stopwatch batch_watch;
+      table.contains_batch(workload.lookups.data(), n, results.get());
+      batch_ms += batch_watch.elapsed_ms();
+      do_not_optimize(results[n - 1]);
+    }
+
+    // Inserts take fresh keys and erases take the oldest present ones, so
+    // the table size stays roughly constant.
+    uint64_t seed = round;
+    size_t next_insert = 0, next_erase = 0;
+    Stopwatch mixed_watch;
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t r = next_random(seed) % 10;
+      if (r == 0 && next_insert < n)
+        insert(table, workload.missing[next_insert++], 0);
+      else if (r == 1 && next_erase < n)
+        table.erase(workload.present[next_erase++]);
+      else
+        found += table.find(workload.lookups[i]) != table.end();
+    }
+    mixed_ms += mixed_watch.elapsed_ms();
+    do_not_optimize(found);
+
+    Stopwatch erase_watch;
+    for (const Key &key : workload.lookups)
+      table.erase(key);
+    erase_ms += erase_watch.elapsed_ms();
+  }
+
+  const char *names[] = {"insert", "find_hit", "find_miss", "erase",
+                         "mixed",  "bulk_load", "find_batch"};
+  double totals[] = {insert_ms, hit_ms,  miss_ms, erase_ms,
+                     mixed_ms,  bulk_ms, batch_ms};
+  bool offered[] = {true, true, true, true, true, has_bulk_load<Table>::value,
+                    has_batch_lookup<Table>::value};
+  for (int i = 0; i < 7; ++i)
+    if (offered[i])
+      std::printf("%s,%s,%zu,%s,%.2f,%.1f\n", table_name, key_name, n,
+                  names[i], totals[i] * 1e6 / (double(n) * rounds),
+                  double(bytes) / n);
+  std::fflush(stdout);
+}
+
+template <typename Key, typename HashFunction>
+void run_all(const char *key_name, size_t n, const char *filter) {
+  Workload<Key> workload = make_workload<Key>(n);
+  auto selected = [filter](const char *name) {
+    return filter == nullptr || std::strstr(name, filter) != nullptr;
+  };
+
+  if (selected("linear"))
+    run_table<OpenAddressingHashTable<Key, int, HashFunction,
+                                      LinearHashing<Key>>>("linear", key_name,
+                                                           workload);
+  if (selected("quadratic"))
+    run_table<OpenAddressingHashTable<Key, int, HashFunction,
+                                      QuadraticHashing<Key>>>(
+        "quadratic", key_name, workload);
+  if (selected("double"))
+    run_table<OpenAddressingHashTable<Key, int, HashFunction,
+                                      DoubleHashing<Key>>>("double", key_name,
+                                                           workload);
+  using Linear =
+      OpenAddressingHashTable<Key, int, HashFunction, LinearHashing<Key>>;
+  if (selected("linear_ml50"))
+    run_table<WithMaxLoad<Linear, 500>>("linear_ml50", key_name, workload);
+  if (selected("linear_ml875"))
+    run_table<WithMaxLoad<Linear, 875>>("linear_ml875", key_name, workload);
+  if (selected("linear_x1_5"))
+    run_table<OpenAddressingHashTable<Key, int, HashFunction,
+                                      LinearHashing<Key>,
+                                      std::allocator<Entry<Key, int>>,
+                                      OneAndHalfGrowth>>("linear_x1_5",
+                                                         key_name, workload);
+  if (selected("linear_telemetry"))
+    run_table<WithTelemetry<Linear>>("linear_telemetry", key_name, workload);
+  if (selected("linear_store_hash"))
+    run_table<OpenAddressingHashTable<Key, int, StoreHash<HashFunction>,
+                                      LinearHashing<Key>>>(
+        "linear_store_hash", key_name, workload);
+  if constexpr (std::is_same_v<Key, std::string>)
+    if (selected("compact_string"))
+      run_table<CompactStringHashTable<int, HashFunction>>(
+          "compact_string", key_name, workload);
+  if (selected("robin_hood"))
+    run_table<RobinHoodHashTable<Key, int, HashFunction>>("robin_hood",
+                                                          key_name, workload);
+  if (selected("cuckoo"))
+    run_table<CuckooHashTable<Key, int, HashFunction>>("cuckoo", key_name,
+                                                       workload);
+  if (selected("cuckoo_8"))
+    run_table<CuckooHashTable<Key, int, HashFunction, 8>>("cuckoo_8",
+                                                          key_name, workload);
+  if (selected("std_unordered_map"))
+    run_table<std::unordered_map<Key, int>>("std_unordered_map", key_name,
+                                            workload);
+}
+
+int main(int argc, char **argv) {
+  size_t max_size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 3 << 20;
+  const char *filter = argc > 2 ? argv[2] : nullptr;
+
+  std::printf("table,key,size,workload,ns_per_op,bytes_per_key\n");
+  // Sizes sit at 3/4 of a power of two, so max_load_factor and the growth
+  // policy decide whether the table has grown past it.
+  for (size_t n = 3 << 8; n <= max_size; n *= 16) {
+    run_all<int, Hash<int>>("int", n, filter);
+    run_all<std::string, Hash<std::string>>("string", n, filter);
+  }
+  return 0;
+}
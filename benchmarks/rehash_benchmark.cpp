@@ -0,0 +1,92 @@
+#include "benchmark_utils.h"
+#include "open_addressing_hash_table.h"
+#include <cstdio>
+#include <cstdlib>
+
+// Time to double a full table with the serial rehash() and with
+// parallel_rehash() on 2, 4, ... max_threads threads, and to build a table
+// from the same pairs with bulk_insert() and with parallel_build(). The scan
+// rows sum the values of the full table, through its iterator and through
+// parallel_reduce().
+//
+// Usage: RehashBenchmark [elements] [max_threads]
+//
+// Prints CSV: operation,key,elements,threads,ms (threads 0 is the serial
+// rehash, bulk_insert or iterator). String tables get a quarter of the
+// elements.
+
+template <typename Table, typename Key>
+void run(const char *key_name, const std::vector<Key> &keys,
+         unsigned max_threads) {
+  Table table;
+  table.bulk_insert(keys.begin(), keys.end());
+  size_t capacity = table.bucket_count() * 2;
+
+  for (unsigned threads = 0; threads <= max_threads;
+       threads = threads == 0 ? 2 : threads * 2) {
+    Table copy(table);
+    Stopwatch watch;
+    if (threads == 0)
+      copy.rehash(capacity);
+    else
+      copy.parallel_rehash(capacity, threads);
+    double ms = watch.elapsed_ms();
+    do_not_optimize(copy.size());
+    std::printf("rehash,%s,%zu,%u,%.1f\n", key_name, keys.size(), threads,
+                ms);
+    std::fflush(stdout);
+  }
+
+  for (unsigned threads = 0; threads <= max_threads;
+       threads = threads == 0 ? 2 : threads * 2) {
+    Table built;
+    Stopwatch watch;
+    if (threads == 0)
+      built.bulk_insert(keys.begin(), keys.end());
+    else
+      built.parallel_build(keys.begin(), keys.end(), threads);
+    double ms = watch.elapsed_ms();
+    do_not_optimize(built.size());
+    std::printf("build,%s,%zu,%u,%.1f\n", key_name, keys.size(), threads,
+                ms);
+    std::fflush(stdout);
+  }
+
+  for (unsigned threads = 0; threads <= max_threads;
+       threads = threads == 0 ? 1 : threads * 2) {
+    long long sum = 0;
+    Stopwatch watch;
+    if (threads == 0) {
+      for (auto &entry : table)
+        sum += entry.value;
+    } else {
+      sum = table.parallel_reduce(
+          0LL, [](const auto &entry) { return (long long)entry.value; },
+          [](long long a, long long b) { return a + b; }, threads);
+    }
+    double ms = watch.elapsed_ms();
+    do_not_optimize(sum);
+    std::printf("scan,%s,%zu,%u,%.1f\n", key_name, keys.size(), threads, ms);
+    std::fflush(stdout);
+  }
+}
+
+int main(int argc, char **argv) {
+  size_t elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 24;
+  unsigned max_threads =
+      argc > 2 ? std::atoi(argv[2]) : std::max(2u, default_thread_count());
+
+  std::vector<std::pair<int, int>> int_keys;
+  for (int key : random_int_keys(elements, 1))
+    int_keys.emplace_back(key, key);
+  run<OpenAddressingHashTable<int, int, Hash<int>>>("int", int_keys,
+                                                    max_threads);
+  int_keys = {};
+
+  std::vector<std::pair<std::string, int>> string_keys;
+  for (int key : random_int_keys(elements / 4, 2))
+    string_keys.emplace_back("key_" + std::to_string(key), key);
+  run<OpenAddressingHashTable<std::string, int, Hash<std::string>>>(
+      "string", string_keys, max_threads);
+  return 0;
+}
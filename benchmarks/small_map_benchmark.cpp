@@ -0,0 +1,87 @@
+#include "benchmark_utils.h"
+#include "small_hash_table.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+// Many tiny maps, as in per-object attribute maps: builds `maps` maps of
+// `entries` int keys each, then looks up present keys in random maps.
+// Allocations are counted by replacing the global operator new.
+//
+//   build_ns    ns per map to construct and fill it
+//   find_ns     ns per lookup
+//   allocs      heap allocations per map
+//   bytes       sizeof(map) plus heap bytes per map
+//
+// Usage: SmallMapBenchmark [maps]
+//
+// Prints CSV: table,entries,build_ns,find_ns,allocs,bytes
+
+size_t allocations = 0;
+size_t allocated_bytes = 0;
+
+void *operator new(size_t size) {
+  ++allocations;
+  allocated_bytes += size;
+  if (void *p = std::malloc(size == 0 ? 1 : size))
+    return p;
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+constexpr size_t LOOKUPS = size_t(1) << 22;
+
+template <typename Map>
+void run(const char *name, size_t maps, int entries) {
+  std::vector<Map> all(maps);
+  size_t allocations_before = allocations;
+  size_t bytes_before = allocated_bytes;
+  Stopwatch build;
+  for (size_t m = 0; m < maps; ++m) {
+    Map map;
+    for (int i = 0; i < entries; ++i)
+      map[static_cast<int>(m * 31 + i)] = i;
+    all[m] = std::move(map);
+  }
+  double build_ms = build.elapsed_ms();
+  size_t map_allocations = allocations - allocations_before;
+  size_t map_bytes = allocated_bytes - bytes_before;
+
+  double find_ms = 0;
+  if (entries > 0) {
+    uint64_t seed = 7;
+    size_t hits = 0;
+    Stopwatch find;
+    for (size_t i = 0; i < LOOKUPS; ++i) {
+      uint64_t r = next_random(seed);
+      size_t m = r % maps;
+      int key = static_cast<int>(m * 31 + (r >> 32) % entries);
+      hits += all[m].find(key) != all[m].end();
+    }
+    find_ms = find.elapsed_ms();
+    do_not_optimize(hits);
+  }
+
+  std::printf("%s,%d,%.1f,%.2f,%.2f,%.1f\n", name, entries,
+              build_ms * 1e6 / maps, find_ms * 1e6 / LOOKUPS,
+              double(map_allocations) / maps,
+              sizeof(Map) + double(map_bytes) / maps);
+  std::fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+  size_t maps = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 18;
+
+  std::printf("table,entries,build_ns,find_ns,allocs,bytes\n");
+  for (int entries : {0, 1, 2, 4, 8, 16}) {
+    run<SmallHashTable<int, int, 8, Hash<int>>>("small_8", maps, entries);
+    run<OpenAddressingHashTable<int, int, Hash<int>>>("linear", maps,
+                                                      entries);
+    run<std::unordered_map<int, int, Hash<int>>>("unordered_map", maps,
+                                                 entries);
+  }
+  return 0;
+}
@@ -0,0 +1,63 @@
+#include "accelerated_hash.h"
+#include "benchmark_utils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Hashing throughput of the string hash implementations by key length.
+// Each row hashes KEYS distinct keys of one length, laid out back to back in
+// a buffer that fits in L1/L2, so the numbers are the hash's own cost.
+//
+// Usage: StringHashBenchmark [hashes_per_row]
+//
+// Prints CSV: hash,key_bytes,ns_per_hash,gb_per_s
+
+constexpr size_t KEYS = 256;
+
+void run(const char *name, StringHashFunction hash, size_t size,
+         size_t hashes) {
+  std::vector<char> buffer(KEYS * size + 1);
+  uint64_t seed = size;
+  for (char &c : buffer)
+    c = static_cast<char>(next_random(seed));
+
+  size_t rounds = std::max<size_t>(1, hashes / KEYS);
+  size_t sum = 0;
+  Stopwatch watch;
+  for (size_t round = 0; round < rounds; ++round)
+    for (size_t i = 0; i < KEYS; ++i)
+      sum += hash(buffer.data() + i * size, size);
+  double ms = watch.elapsed_ms();
+  do_not_optimize(sum);
+
+  double total = double(rounds) * KEYS;
+  std::printf("%s,%zu,%.2f,%.2f\n", name, size, ms * 1e6 / total,
+              size * total / (ms * 1e6));
+  std::fflush(stdout);
+}
+
+size_t murmur_hash(const char *data, size_t size) {
+  return Hash<std::string>()(std::string_view(data, size));
+}
+
+int main(int argc, char **argv) {
+  size_t hashes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 24;
+
+  std::vector<StringHashImplementation> implementations = {
+      {"murmur", murmur_hash}, {"portable", portable_string_hash}};
+#ifdef HASH_TABLE_X86_DISPATCH
+  if (__builtin_cpu_supports("sse4.2"))
+    implementations.push_back({"crc32c", crc32c_string_hash});
+  if (__builtin_cpu_supports("aes"))
+    implementations.push_back({"aes", aes_string_hash});
+#endif
+  std::fprintf(stderr, "AcceleratedStringHash uses %s\n",
+               string_hash_implementation().name);
+
+  std::printf("hash,key_bytes,ns_per_hash,gb_per_s\n");
+  for (size_t size : {4, 8, 16, 24, 32, 48, 64, 96, 128, 200, 256, 1024})
+    for (const auto &implementation : implementations)
+      run(implementation.name, implementation.hash, size, hashes);
+  return 0;
+}
@@ -0,0 +1,191 @@
+#pragma once
+#include "hash_functions.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HASH_TABLE_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+// String hashing that uses AES-NI or CRC32C where the CPU has them, chosen
+// once at runtime, so one binary runs everywhere and is fast where it can be.
+//
+// Keys of up to 16 bytes take an inline path shared by every implementation:
+// two overlapping loads folded by one 64x64->128 multiply, no loop, no call.
+// Longer keys go through a function pointer to the best implementation:
+//
+//   aes      two 16-byte AES lanes, 32 bytes per step
+//   crc32c   three CRC32C lanes, 24 bytes per step
+//   portable Hash<std::string> (MurmurHash64A), 8 bytes per step
+//
+// The implementations produce different values, so hashes must not outlive
+// the process: AcceleratedStringHash has no snapshot_id and tables using it
+// cannot be map()ped by a binary that may run on another CPU. None of them
+// is meant to resist deliberately colliding keys.
+
+using StringHashFunction = size_t (*)(const char *data, size_t size);
+
+namespace string_hash_detail {
+
+constexpr uint64_t SEED0 = 0xa0761d6478bd642fULL;
+constexpr uint64_t SEED1 = 0xe7037ed1a0b428dbULL;
+constexpr uint64_t SEED2 = 0x8ebc6af09c88c6e3ULL;
+
+inline uint64_t load64(const char *p) {
+  uint64_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint64_t load32(const char *p) {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+// Folds the 128-bit product of a and b to 64 bits.
+inline uint64_t multiply_fold(uint64_t a, uint64_t b) {
+  __uint128_t product = static_cast<__uint128_t>(a) * b;
+  return static_cast<uint64_t>(product) ^
+         static_cast<uint64_t>(product >> 64);
+}
+
+} // namespace string_hash_detail
+
+// Keys of at most 16 bytes. Every byte lands in a or b, and the length is
+// mixed in, so keys that are prefixes of each other still differ.
+inline size_t short_string_hash(const char *data, size_t size) {
+  using namespace string_hash_detail;
+  uint64_t a = 0, b = 0;
+  if (size >= 8) {
+    a = load64(data);
+    b = load64(data + size - 8);
+  } else if (size >= 4) {
+    a = load32(data);
+    b = load32(data + size - 4);
+  } else if (size > 0) {
+    a = (uint64_t(uint8_t(data[0])) << 16) |
+        (uint64_t(uint8_t(data[size / 2])) << 8) | uint8_t(data[size - 1]);
+  }
+  uint64_t h = multiply_fold(a ^ SEED0, b ^ SEED1 ^ size);
+  return static_cast<size_t>(multiply_fold(h ^ SEED2, SEED0 ^ size));
+}
+
+inline size_t portable_string_hash(const char *data, size_t size) {
+  if (size <= 16)
+    return short_string_hash(data, size);
+  return Hash<std::string>()(std::string_view(data, size));
+}
+
+#ifdef HASH_TABLE_X86_DISPATCH
+// Each step XORs 16 bytes into a lane and runs one AES round on it; three
+// more rounds over both lanes finish the diffusion. The tail is the last 32
+// bytes of the key, overlapping the previous step.
+__attribute__((target("aes"))) inline size_t aes_string_hash(const char *data,
+                                                              size_t size) {
+  using namespace string_hash_detail;
+  if (size <= 16)
+    return short_string_hash(data, size);
+
+  auto load = [](const char *p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  };
+  const __m128i key = _mm_set_epi64x(SEED1, SEED2);
+  __m128i lane0 = _mm_set_epi64x(static_cast<long long>(size), SEED0);
+  __m128i lane1 = _mm_set_epi64x(SEED2, static_cast<long long>(size));
+  if (size <= 32) {
+    lane0 = _mm_aesenc_si128(_mm_xor_si128(lane0, load(data)), key);
+    lane1 = _mm_aesenc_si128(_mm_xor_si128(lane1, load(data + size - 16)), key);
+  } else {
+    const char *last = data + size - 32;
+    for (; data < last; data += 32) {
+      lane0 = _mm_aesenc_si128(_mm_xor_si128(lane0, load(data)), key);
+      lane1 = _mm_aesenc_si128(_mm_xor_si128(lane1, load(data + 16)), key);
+    }
+    lane0 = _mm_aesenc_si128(_mm_xor_si128(lane0, load(last)), key);
+    lane1 = _mm_aesenc_si128(_mm_xor_si128(lane1, load(last + 16)), key);
+  }
+
+  __m128i h = _mm_aesenc_si128(lane0, lane1);
+  h = _mm_aesenc_si128(h, key);
+  h = _mm_aesdec_si128(h, lane0);
+  return static_cast<size_t>(_mm_cvtsi128_si64(h) ^
+                             _mm_cvtsi128_si64(_mm_unpackhi_epi64(h, h)));
+}
+
+// Three independent CRC32C lanes keep the crc32 unit busy (latency 3,
+// throughput 1); their 96 bits are folded by a multiply at the end. The tail
+// is the last 24 bytes of the key, overlapping the previous step.
+__attribute__((target("sse4.2"))) inline size_t
+crc32c_string_hash(const char *data, size_t size) {
+  using namespace string_hash_detail;
+  if (size <= 16)
+    return short_string_hash(data, size);
+
+  uint64_t crc0 = static_cast<uint32_t>(SEED0);
+  uint64_t crc1 = static_cast<uint32_t>(SEED1);
+  uint64_t crc2 = static_cast<uint32_t>(SEED2);
+  if (size <= 24) {
+    crc0 = _mm_crc32_u64(crc0, load64(data));
+    crc1 = _mm_crc32_u64(crc1, load64(data + 8));
+    crc2 = _mm_crc32_u64(crc2, load64(data + size - 8));
+  } else {
+    const char *last = data + size - 24;
+    for (; data < last; data += 24) {
+      crc0 = _mm_crc32_u64(crc0, load64(data));
+      crc1 = _mm_crc32_u64(crc1, load64(data + 8));
+      crc2 = _mm_crc32_u64(crc2, load64(data + 16));
+    }
+    crc0 = _mm_crc32_u64(crc0, load64(last));
+    crc1 = _mm_crc32_u64(crc1, load64(last + 8));
+    crc2 = _mm_crc32_u64(crc2, load64(last + 16));
+  }
+
+  uint64_t h = multiply_fold(((crc0 << 32) | crc1) ^ SEED0,
+                             ((crc2 << 32) | size) ^ SEED1);
+  return static_cast<size_t>(multiply_fold(h ^ SEED2, SEED0 ^ size));
+}
+#endif // HASH_TABLE_X86_DISPATCH
+
+struct StringHashImplementation {
+  const char *name;
+  StringHashFunction hash;
+};
+
+// Best implementation this CPU supports.
+inline StringHashImplementation select_string_hash() {
+#ifdef HASH_TABLE_X86_DISPATCH
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("aes"))
+    return {"aes", aes_string_hash};
+  if (__builtin_cpu_supports("sse4.2"))
+    return {"crc32c", crc32c_string_hash};
+#endif
+  return {"portable", portable_string_hash};
+}
+
+inline const StringHashImplementation &string_hash_implementation() {
+  static const StringHashImplementation implementation = select_string_hash();
+  return implementation;
+}
+
+// Drop-in for Hash<std::string>, transparent in the same way.
+struct AcceleratedStringHash {
+  using is_transparent = void;
+
+  size_t operator()(const std::string &key) const {
+    return (*this)(std::string_view(key));
+  }
+  size_t operator()(const char *key) const {
+    return (*this)(std::string_view(key));
+  }
+  size_t operator()(std::string_view key) const {
+    if (key.size() <= 16)
+      return short_string_hash(key.data(), key.size());
+    return string_hash_implementation().hash(key.data(), key.size());
+  }
+};
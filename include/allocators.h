@@ -0,0 +1,150 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// Bump allocator for request-scoped tables. Memory is carved out of blocks of
+// at least block_size bytes and only returned when the Arena is reset or
+// destroyed, so a table that grows leaves its old slot arrays behind until
+// then; reserve() up front keeps that waste away.
+class Arena {
+public:
+  explicit Arena(size_t block_size = 1 << 16) : block_size(block_size) {}
+  Arena(const Arena &) = delete;
+  void operator=(const Arena &) = delete;
+
+  void *allocate(size_t bytes, size_t alignment) {
+    uintptr_t aligned = (cursor + alignment - 1) & ~(alignment - 1);
+    if (aligned + bytes > limit) {
+      size_t size = std::max(block_size, bytes + alignment);
+      blocks.emplace_back(new std::byte[size]);
+      cursor = reinterpret_cast<uintptr_t>(blocks.back().get());
+      limit = cursor + size;
+      aligned = (cursor + alignment - 1) & ~(alignment - 1);
+    }
+    cursor = aligned + bytes;
+    allocated += bytes;
+    return reinterpret_cast<void *>(aligned);
+  }
+
+  // Frees every block; everything allocated from the arena is gone.
+  void reset() {
+    blocks.clear();
+    cursor = limit = 0;
+    allocated = 0;
+  }
+
+  size_t bytes_allocated() const noexcept { return allocated; }
+
+private:
+  size_t block_size;
+  std::vector<std::unique_ptr<std::byte[]>> blocks;
+  uintptr_t cursor = 0;
+  uintptr_t limit = 0;
+  size_t allocated = 0;
+};
+
+// Standard allocator over an Arena. deallocate is a no-op; the arena owns the
+// memory.
+template <typename T> class ArenaAllocator {
+public:
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena &arena) noexcept : arena(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) noexcept
+      : arena(other.arena) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *, size_t) noexcept {}
+
+  template <typename U> bool operator==(const ArenaAllocator<U> &other) const {
+    return arena == other.arena;
+  }
+  template <typename U> bool operator!=(const ArenaAllocator<U> &other) const {
+    return arena != other.arena;
+  }
+
+private:
+  template <typename U> friend class ArenaAllocator;
+  Arena *arena;
+};
+
+#ifdef __linux__
+// Backs large arrays with 2MB pages to cut TLB misses on tables far bigger
+// than the TLB reach. Allocations of at least MIN_BYTES go to mmap: first
+// with MAP_HUGETLB (needs reserved huge pages, see vm.nr_hugepages), then as
+// ordinary anonymous memory with madvise(MADV_HUGEPAGE) so transparent huge
+// pages can back it. Smaller allocations use plain operator new, which ignores
+// an alignof(T) above __STDCPP_DEFAULT_NEW_ALIGNMENT__; the mmap path is
+// aligned to HUGE_PAGE_SIZE.
+template <typename T> class HugePageAllocator {
+public:
+  using value_type = T;
+
+  static constexpr size_t HUGE_PAGE_SIZE = size_t(1) << 21;
+  static constexpr size_t MIN_BYTES = HUGE_PAGE_SIZE / 2;
+
+  HugePageAllocator() noexcept = default;
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U> &) noexcept {}
+
+  T *allocate(size_t n) {
+    size_t bytes = n * sizeof(T);
+    if (bytes < MIN_BYTES)
+      return static_cast<T *>(::operator new(bytes));
+
+    size_t length = mapped_length(bytes);
+    void *memory = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory == MAP_FAILED) {
+      // THP only backs 2MB-aligned ranges: map one huge page extra and unmap
+      // the slack on both sides of the aligned start.
+      memory = mmap(nullptr, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (memory == MAP_FAILED)
+        throw std::bad_alloc();
+      uintptr_t start = reinterpret_cast<uintptr_t>(memory);
+      uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+      if (aligned != start)
+        munmap(memory, aligned - start);
+      munmap(reinterpret_cast<void *>(aligned + length),
+             start + HUGE_PAGE_SIZE - aligned);
+      memory = reinterpret_cast<void *>(aligned);
+      madvise(memory, length, MADV_HUGEPAGE);
+    }
+    return static_cast<T *>(memory);
+  }
+
+  void deallocate(T *pointer, size_t n) noexcept {
+    size_t bytes = n * sizeof(T);
+    if (bytes < MIN_BYTES)
+      ::operator delete(pointer);
+    else
+      munmap(pointer, mapped_length(bytes));
+  }
+
+  template <typename U>
+  bool operator==(const HugePageAllocator<U> &) const noexcept {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const HugePageAllocator<U> &) const noexcept {
+    return false;
+  }
+
+private:
+  static size_t mapped_length(size_t bytes) {
+    return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+  }
+};
+#endif // __linux__
@@ -0,0 +1,453 @@
+#pragma once
+#include "open_addressing_hash_table.h"
+#include <cstring>
+#include <string_view>
+
+// String-keyed map that stores no std::string. Every key takes 16 bytes in
+// its slot: keys of up to 15 bytes sit there whole, longer ones go into one
+// byte arena owned by the table and the slot keeps their length, their first
+// four bytes and their arena offset. Short keys are compared as two words
+// without leaving the slot; long keys are rejected on length and prefix
+// before the arena is touched. Erased long keys leave garbage in the arena,
+// which every rehash drops by copying the live keys into a fresh one.
+//
+// Probing, control bytes, growth and the load and tombstone factors work as
+// in OpenAddressingHashTable with the default DoublingGrowth. Keys are taken
+// and returned as string_views; a view returned by the table is invalidated
+// by the next insert or rehash.
+
+// The in-slot form of a key.
+struct CompactKey {
+  static constexpr size_t INLINE_MAX = 15;
+  // Last byte of a key stored in the arena; inline keys put their length
+  // there, which is at most INLINE_MAX.
+  static constexpr unsigned char LONG_KEY = 0xFF;
+
+  unsigned char bytes[16] = {};
+
+  // Inline form of key, or for a long key its length, prefix and marker
+  // with offset 0.
+  static CompactKey encode(std::string_view key) {
+    CompactKey encoded;
+    if (key.size() <= INLINE_MAX) {
+      std::memcpy(encoded.bytes, key.data(), key.size());
+      encoded.bytes[15] = static_cast<unsigned char>(key.size());
+      return encoded;
+    }
+    uint32_t size = static_cast<uint32_t>(key.size());
+    std::memcpy(encoded.bytes, &size, sizeof(size));
+    std::memcpy(encoded.bytes + 4, key.data(), 4);
+    encoded.bytes[15] = LONG_KEY;
+    return encoded;
+  }
+
+  bool is_inline() const { return bytes[15] != LONG_KEY; }
+  size_t size() const {
+    if (is_inline())
+      return bytes[15];
+    uint32_t size;
+    std::memcpy(&size, bytes, sizeof(size));
+    return size;
+  }
+  // Arena offset of a long key, 56 bits in bytes [8, 15).
+  size_t offset() const {
+    uint64_t offset = 0;
+    for (int i = 6; i >= 0; --i)
+      offset = (offset << 8) | bytes[8 + i];
+    return static_cast<size_t>(offset);
+  }
+  void set_offset(size_t offset) {
+    for (int i = 0; i < 7; ++i)
+      bytes[8 + i] = static_cast<unsigned char>(offset >> (8 * i));
+  }
+  std::string_view view(const char *arena) const {
+    if (is_inline())
+      return std::string_view(reinterpret_cast<const char *>(bytes), size());
+    return std::string_view(arena + offset(), size());
+  }
+};
+
+// A key being looked up: its encoded form plus what a long key is checked
+// against in the arena.
+struct CompactKeyLookup {
+  CompactKey encoded;
+  std::string_view key;
+  const char *arena;
+};
+
+inline bool operator==(const CompactKey &stored,
+                       const CompactKeyLookup &lookup) {
+  uint64_t a[2], b[2];
+  std::memcpy(a, stored.bytes, sizeof(a));
+  std::memcpy(b, lookup.encoded.bytes, sizeof(b));
+  if (lookup.encoded.is_inline())
+    return a[0] == b[0] && a[1] == b[1];
+  // Length and prefix, then the marker.
+  return a[0] == b[0] && stored.bytes[15] == CompactKey::LONG_KEY &&
+         std::memcmp(lookup.arena + stored.offset(), lookup.key.data(),
+                     lookup.key.size()) == 0;
+}
+
+template <typename V> struct CompactEntry {
+  CompactKey key;
+  V value;
+};
+
+template <typename V, typename HashFunction = Hash<std::string>,
+          typename ProbingPolicy = LinearHashing<std::string>> //
+class CompactStringHashTable {
+public:
+  using key_type = std::string_view;
+  using mapped_type = V;
+  using size_type = size_t;
+
+  // What iterators point at: the key as a view and the value in place.
+  struct reference {
+    std::string_view key;
+    V &value;
+  };
+
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = reference;
+    using pointer = const reference *;
+
+    iterator(CompactStringHashTable *table, size_type index)
+        : table(table), index(index) {
+      skip_empty();
+    }
+
+    iterator operator++() {
+      ++index;
+      skip_empty();
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator temp = *this;
+      ++*this;
+      return temp;
+    }
+
+    bool operator==(const iterator &other) const {
+      return index == other.index;
+    }
+    bool operator!=(const iterator &other) const { return !(*this == other); }
+
+    reference operator*() const {
+      CompactEntry<V> &entry = table->data[index];
+      return {entry.key.view(table->arena.data()), entry.value};
+    }
+    // operator-> needs an object to point at; this one lives as long as the
+    // full expression.
+    struct arrow {
+      reference ref;
+      const reference *operator->() const { return &ref; }
+    };
+    arrow operator->() const { return {**this}; }
+
+  private:
+    CompactStringHashTable *table;
+    size_type index;
+
+    void skip_empty() {
+      while (index < table->data.size() && !is_full(table->ctrl[index]))
+        ++index;
+    }
+  };
+
+  CompactStringHashTable()
+      : data(4), ctrl(control_size(4), CTRL_EMPTY), num_elements(0),
+        num_deleted(0) {}
+  explicit CompactStringHashTable(size_type size_hint)
+      : CompactStringHashTable() {
+    reserve(size_hint);
+  }
+
+  iterator begin() noexcept { return iterator(this, 0); }
+  iterator end() noexcept { return iterator(this, data.size()); }
+
+  std::pair<iterator, bool> insert(std::string_view key, mapped_type value) {
+    return try_emplace(key, std::move(value));
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(std::string_view key, Args &&...args);
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(std::string_view key, M &&value);
+  template <typename InputIt> void bulk_insert(InputIt first, InputIt last);
+  size_type erase(std::string_view key);
+  iterator find(std::string_view key) {
+    return iterator(this, find_index(key, hasher(key)));
+  }
+  bool contains(std::string_view key) const {
+    return find_index(key, hasher(key)) != data.size();
+  }
+
+  mapped_type &operator[](std::string_view key) {
+    return try_emplace(key).first->value;
+  }
+  mapped_type &at(std::string_view key);
+
+  void rehash(size_type new_capacity);
+  void reserve(size_type count);
+
+  size_type size() const noexcept { return num_elements; }
+  bool empty() const noexcept { return num_elements == 0; }
+  size_type bucket_count() const noexcept { return data.size(); }
+  float load_factor() const noexcept {
+    return static_cast<float>(num_elements) / data.size();
+  }
+  // As in OpenAddressingHashTable.
+  float max_load_factor() const noexcept { return max_load; }
+  void max_load_factor(float factor);
+  float max_tombstone_factor() const noexcept { return max_tombstones; }
+  void max_tombstone_factor(float factor);
+  // Bytes held by the arena, including those of erased keys.
+  size_type arena_bytes() const noexcept { return arena.size(); }
+  // Slot arrays plus arena capacity.
+  size_type memory_bytes() const noexcept {
+    return data.size() * (sizeof(CompactEntry<V>) + sizeof(ctrl_t)) +
+           arena.capacity();
+  }
+
+  void clear() noexcept;
+
+private:
+  std::vector<CompactEntry<V>> data;
+  std::vector<ctrl_t> ctrl;
+  std::vector<char> arena;
+  HashFunction hasher;
+  ProbingPolicy probe;
+  size_type num_elements;
+  size_type num_deleted;
+  float max_load = LOAD_FACTOR;
+  float max_tombstones = DELETE_FACTOR;
+  // Arena bytes that belong to erased keys.
+  size_type arena_garbage = 0;
+
+  static size_type control_size(size_type capacity) {
+    return capacity + Group::WIDTH - 1;
+  }
+  void set_ctrl(size_type index, ctrl_t value) {
+    ctrl[index] = value;
+    if (index < Group::WIDTH - 1)
+      ctrl[data.size() + index] = value;
+  }
+  size_type capacity_for(size_type count) const {
+    size_type capacity = 4;
+    while (static_cast<float>(count) / capacity > max_load)
+      capacity *= 2;
+    return capacity;
+  }
+
+  size_type find_index(std::string_view key, size_t hash) const {
+    CompactKeyLookup lookup{CompactKey::encode(key), key, arena.data()};
+    return find_slot<false>(probe, ctrl.data(), data.data(), nullptr,
+                            data.size(), lookup, hash);
+  }
+  size_type find_insert_index(size_t hash) const;
+  // True if key points into the arena or the slots, as the table's own
+  // views (also those of erased keys) do.
+  bool in_table(std::string_view key) const {
+    std::less<const char *> before;
+    auto inside = [&](const void *begin, size_t bytes) {
+      const char *first = static_cast<const char *>(begin);
+      return !before(key.data(), first) && before(key.data(), first + bytes);
+    };
+    return inside(arena.data(), arena.size()) ||
+           inside(data.data(), data.size() * sizeof(CompactEntry<V>));
+  }
+  // Writes key into slot index, appending a long key to the arena.
+  void store_key(size_type index, std::string_view key);
+};
+
+template <typename V, typename HashFunction, typename ProbingPolicy>
+typename CompactStringHashTable<V, HashFunction, ProbingPolicy>::size_type
+CompactStringHashTable<V, HashFunction, ProbingPolicy>::find_insert_index(
+    size_t hash) const {
+  const size_t capacity = data.size();
+
+  if constexpr (is_linear_probing<ProbingPolicy>::value) {
+    if (capacity >= Group::WIDTH) {
+      size_t pos = probe(hash, 0, capacity);
+      while (true) {
+        BitMask free = Group(ctrl.data() + pos).match_empty_or_deleted();
+        if (free)
+          return wrap_slot(pos + free.lowest(), capacity);
+        pos = wrap_slot(pos + Group::WIDTH, capacity);
+      }
+    }
+  }
+
+  size_t i = 0;
+  size_t index = probe(hash, i, capacity);
+  while (is_full(ctrl[index]))
+    index = probe(hash, ++i, capacity);
+  return index;
+}
+
+template <typename V, typename HashFunction, typename ProbingPolicy>
+void CompactStringHashTable<V, HashFunction, ProbingPolicy>::store_key(
+    size_type index, std::string_view key) {
+  CompactKey encoded = CompactKey::encode(key);
+  if (!encoded.is_inline()) {
+    encoded.set_offset(arena.size());
+    arena.insert(arena.end(), key.begin(), key.end());
+  }
+  data[index].key = encoded;
+}
+
+template <typename V, typename HashFunction, typename ProbingPolicy>
+template <typename... Args>
+std::pair<typename CompactStringHashTable<V, HashFunction,
+                                          ProbingPolicy>::iterator,
+          bool>
+CompactStringHashTable<V, HashFunction, ProbingPolicy>::try_emplace(
+    std::string_view key, Args &&...args) {
+  size_t hash = hasher(key);
+  size_t index = find_index(key, hash);
+  if (index != data.size())
+    return {iterator(this, index), false};
+
+  // Rehashing or appending to the arena may move it from under such a key.
+  std::string copy;
+  if (in_table(key)) {
+    copy.assign(key);
+    key = copy;
+  }
+
+  if (static_cast<float>(num_elements + 1) / data.size() > max_load)
+    rehash(data.size() * 2);
+
+  index = find_insert_index(hash);
+  if (ctrl[index] == CTRL_DELETED)
+    num_deleted--;
+  data[index].value = mapped_type(std::forward<Args>(args)...);
+  store_key(index, key);
+  set_ctrl(index, ctrl_tag(hash));
+  num_elements++;
+  return {iterator(this, index), true};
+}
+
+template <typename V, typename HashFunction, typename ProbingPolicy>
+template <typename M>
+std::pair<typename CompactStringHashTable<V, HashFunction,
+                                          ProbingPolicy>::iterator,
+          bool>
+CompactStringHashTable<V, HashFunction, ProbingPolicy>::insert_or_assign(
+    std::string_view key, M &&value) {
+  auto result = try_emplace(key, std::forward<M>(value));
+  if (!result.second)
+    result.first->value = std::forward<M>(value);
+  return result;
+}
+
+template <typename V, typename HashFunction, typename ProbingPolicy>
+template <typename InputIt>
+void CompactStringHashTable<V, HashFunction, ProbingPolicy>::bulk_insert(
+    InputIt first, InputIt last) {
+  if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                                  typename std::iterator_traits<
+                                      InputIt>::iterator_category>)
+    reserve(num_elements + std::distance(first, last));
+  for (; first != last; ++first)
+    try_emplace(first->first, first->second);
+}
+
+template <typename V, typename HashFunction, typename ProbingPolicy>
+typename CompactStringHashTable<V, HashFunction, ProbingPolicy>::size_type
+CompactStringHashTable<V, HashFunction, ProbingPolicy>::erase(
+    std::string_view key) {
+  // The tombstone sweep doubles as arena compaction once half of it is
+  // garbage; it moves the arena and slots from under a key viewing them.
+  std::string copy;
+  if (in_table(key)) {
+    copy.assign(key);
+    key = copy;
+  }
+  if (static_cast<float>(num_deleted) / data.size() > max_tombstones ||
+      (arena_garbage > 4096 && arena_garbage > arena.size() / 2))
+    rehash(std::min(data.size(), capacity_for(2 * num_elements)));
+
+  size_t index = find_index(key, hasher(key));
+  if (index == data.size())
+    return 0;
+
+  if (!data[index].key.is_inline())
+    arena_garbage += data[index].key.size();
+  set_ctrl(index, CTRL_DELETED);
+  --num_elements;
+  ++num_deleted;
+  return 1;
+}
+
+template <typename V, typename HashFunction, typename ProbingPolicy>
+V &CompactStringHashTable<V, HashFunction, ProbingPolicy>::at(
+    std::string_view key) {
+  size_t index = find_index(key, hasher(key));
+  if (index == data.size())
+    throw std::out_of_range("function at(): key was not found");
+  return data[index].value;
+}
+
+template <typename V, typename HashFunction, typename ProbingPolicy>
+void CompactStringHashTable<V, HashFunction, ProbingPolicy>::rehash(
+    size_type new_capacity) {
+  new_capacity = std::max(new_capacity, capacity_for(num_elements));
+  std::vector<CompactEntry<V>> old_data = std::move(data);
+  std::vector<ctrl_t> old_ctrl = std::move(ctrl);
+  std::vector<char> old_arena = std::move(arena);
+  data = std::vector<CompactEntry<V>>(new_capacity);
+  ctrl.assign(control_size(new_capacity), CTRL_EMPTY);
+  arena.clear();
+  arena.reserve(old_arena.size() - arena_garbage);
+  num_deleted = 0;
+  arena_garbage = 0;
+
+  for (size_t old_index = 0; old_index < old_data.size(); ++old_index) {
+    if (!is_full(old_ctrl[old_index]))
+      continue;
+    CompactEntry<V> &entry = old_data[old_index];
+    std::string_view key = entry.key.view(old_arena.data());
+    size_t hash = hasher(key);
+    size_t new_index = find_insert_index(hash);
+    data[new_index].value = std::move(entry.value);
+    store_key(new_index, key);
+    set_ctrl(new_index, ctrl_tag(hash));
+  }
+}
+
+template <typename V, typename HashFunction, typename ProbingPolicy>
+void CompactStringHashTable<V, HashFunction, ProbingPolicy>::reserve(
+    size_type count) {
+  if (capacity_for(count) > data.size())
+    rehash(capacity_for(count));
+}
+
+template <typename V, typename HashFunction, typename ProbingPolicy>
+void CompactStringHashTable<V, HashFunction, ProbingPolicy>::max_load_factor(
+    float factor) {
+  if (!(factor > 0.0f && factor < 1.0f))
+    throw std::invalid_argument("max_load_factor(): must be in (0, 1)");
+  max_load = factor;
+  if (static_cast<float>(num_elements) / data.size() > max_load)
+    rehash(capacity_for(num_elements));
+}
+
+template <typename V, typename HashFunction, typename ProbingPolicy>
+void CompactStringHashTable<V, HashFunction,
+                            ProbingPolicy>::max_tombstone_factor(float factor) {
+  if (!(factor > 0.0f && factor < 1.0f))
+    throw std::invalid_argument("max_tombstone_factor(): must be in (0, 1)");
+  max_tombstones = factor;
+}
+
+template <typename V, typename HashFunction, typename ProbingPolicy>
+void CompactStringHashTable<V, HashFunction, ProbingPolicy>::clear() noexcept {
+  std::fill(ctrl.begin(), ctrl.end(), CTRL_EMPTY);
+  arena.clear();
+  arena_garbage = 0;
+  num_elements = 0;
+  num_deleted = 0;
+}
@@ -0,0 +1,189 @@
+#pragma once
+#include "open_addressing_hash_table.h"
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+
+// Thread-safe map made of independent OpenAddressingHashTable shards. The
+// shard is picked from the middle bits of the mixed hash (the shard tables
+// probe with the low bits and take their control tags from the top ones),
+// each shard has its own reader-writer lock and grows on its own, so threads
+// only contend when they touch the same shard.
+//
+// Lookups return copies: a reference into a shard would outlive its lock.
+template <typename K, typename V, typename HashFunction = std::hash<K>,
+          typename ProbingPolicy = LinearHashing<K>> //
+class ConcurrentOpenAddressingHashTable {
+public:
+  using table_type = OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>;
+
+  using key_type = K;
+  using mapped_type = V;
+  using size_type = size_t;
+
+  // shard_count is rounded up to a power of two; the default gives every
+  // hardware thread several shards.
+  explicit ConcurrentOpenAddressingHashTable(size_type shard_count = 0);
+
+  bool insert(const key_type &key, mapped_type value);
+  bool insert_or_assign(const key_type &key, mapped_type value);
+  size_type erase(const key_type &key);
+
+  std::optional<mapped_type> find(const key_type &key) const;
+  bool contains(const key_type &key) const;
+
+  // Runs f(mapped_type &) under the shard's exclusive lock, default-inserting
+  // the key first if needed. The way to read-modify-write a value atomically.
+  template <typename F> void update(const key_type &key, F f);
+
+  size_type size() const;
+  bool empty() const { return size() == 0; }
+  void clear();
+
+  size_type shard_count() const noexcept { return size_type(1) << shard_bits; }
+  // Shard that holds key, in [0, shard_count()).
+  size_type shard_index(const key_type &key) const {
+    // Bits 32 and up of the product the control tag is cut from: the top
+    // seven would leave every key of a shard with the same tag.
+    uint64_t mixed = static_cast<uint64_t>(hasher(key)) * 0x9E3779B97F4A7C15ULL;
+    return (mixed >> 32) & (shard_count() - 1);
+  }
+
+  // Attaches telemetry to every shard; its counters are atomic, so all shards
+  // share the one object. telemetry_snapshot() sums the shards' load.
+  void set_telemetry(HashTableTelemetry *telemetry);
+  TelemetrySnapshot telemetry_snapshot() const;
+
+private:
+  struct alignas(64) Shard {
+    mutable std::shared_mutex lock;
+    table_type table;
+  };
+
+  std::unique_ptr<Shard[]> shards;
+  unsigned shard_bits;
+  HashFunction hasher;
+
+  Shard &shard_for(const key_type &key) const {
+    return shards[shard_index(key)];
+  }
+};
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+ConcurrentOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::
+    ConcurrentOpenAddressingHashTable(size_type shard_count)
+    : shard_bits(0) {
+  if (shard_count == 0)
+    shard_count = std::max(1u, std::thread::hardware_concurrency()) * 4;
+  while ((size_type(1) << shard_bits) < shard_count)
+    ++shard_bits;
+  shards = std::make_unique<Shard[]>(size_type(1) << shard_bits);
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+bool ConcurrentOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::
+    insert(const key_type &key, mapped_type value) {
+  Shard &shard = shard_for(key);
+  std::unique_lock<std::shared_mutex> guard(shard.lock);
+  return shard.table.insert(key, std::move(value)).second;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+bool ConcurrentOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::
+    insert_or_assign(const key_type &key, mapped_type value) {
+  Shard &shard = shard_for(key);
+  std::unique_lock<std::shared_mutex> guard(shard.lock);
+  return shard.table.insert_or_assign(key, std::move(value)).second;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+typename ConcurrentOpenAddressingHashTable<K, V, HashFunction,
+                                          ProbingPolicy>::size_type
+ConcurrentOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::erase(
+    const key_type &key) {
+  Shard &shard = shard_for(key);
+  std::unique_lock<std::shared_mutex> guard(shard.lock);
+  return shard.table.erase(key);
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+std::optional<V>
+ConcurrentOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::find(
+    const key_type &key) const {
+  Shard &shard = shard_for(key);
+  std::shared_lock<std::shared_mutex> guard(shard.lock);
+  auto it = shard.table.find(key);
+  if (it == shard.table.end())
+    return std::nullopt;
+  return it->value;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+bool ConcurrentOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::
+    contains(const key_type &key) const {
+  Shard &shard = shard_for(key);
+  std::shared_lock<std::shared_mutex> guard(shard.lock);
+  return shard.table.contains(key);
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+template <typename F>
+void ConcurrentOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::
+    update(const key_type &key, F f) {
+  Shard &shard = shard_for(key);
+  std::unique_lock<std::shared_mutex> guard(shard.lock);
+  f(shard.table[key]);
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+typename ConcurrentOpenAddressingHashTable<K, V, HashFunction,
+                                          ProbingPolicy>::size_type
+ConcurrentOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::size()
+    const {
+  size_type total = 0;
+  for (size_type i = 0; i < shard_count(); ++i) {
+    std::shared_lock<std::shared_mutex> guard(shards[i].lock);
+    total += shards[i].table.size();
+  }
+  return total;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+void ConcurrentOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::
+    clear() {
+  for (size_type i = 0; i < shard_count(); ++i) {
+    std::unique_lock<std::shared_mutex> guard(shards[i].lock);
+    shards[i].table.clear();
+  }
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+void ConcurrentOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::
+    set_telemetry(HashTableTelemetry *telemetry) {
+  for (size_type i = 0; i < shard_count(); ++i) {
+    std::unique_lock<std::shared_mutex> guard(shards[i].lock);
+    shards[i].table.set_telemetry(telemetry);
+  }
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+TelemetrySnapshot
+ConcurrentOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::
+    telemetry_snapshot() const {
+  TelemetrySnapshot result;
+  for (size_type i = 0; i < shard_count(); ++i) {
+    std::shared_lock<std::shared_mutex> guard(shards[i].lock);
+    const table_type &table = shards[i].table;
+    if (i == 0 && table.get_telemetry())
+      result = table.get_telemetry()->snapshot();
+    result.size += table.size();
+    result.capacity += table.bucket_count();
+    result.tombstones += table.num_deleted;
+  }
+  result.load_factor = static_cast<float>(result.size) / result.capacity;
+  result.tombstone_ratio = static_cast<float>(result.tombstones) /
+                           result.capacity;
+  return result;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// One control byte per slot. Full slots keep 7 bits of the hash (high bit
+// clear), free slots have the high bit set, so the probe loop can reject most
+// slots without ever touching their Entry.
+using ctrl_t = int8_t;
+
+constexpr ctrl_t CTRL_EMPTY = -128;  // 0b10000000
+constexpr ctrl_t CTRL_DELETED = -2;  // 0b11111110
+
+inline bool is_full(ctrl_t c) { return c >= 0; }
+
+// The low bits of the hash pick the slot, so the tag is taken from the top of
+// a multiplied hash. Hash<int> only fills the low 32 bits of size_t.
+inline ctrl_t ctrl_tag(size_t hash) {
+  return static_cast<ctrl_t>((static_cast<uint64_t>(hash) *
+                              0x9E3779B97F4A7C15ULL) >> 57);
+}
+
+// Set of matching slot offsets inside a group, lowest offset first.
+class BitMask {
+public:
+  explicit BitMask(uint32_t mask) : mask(mask) {}
+
+  explicit operator bool() const { return mask != 0; }
+  uint32_t lowest() const { return __builtin_ctz(mask); }
+
+  class iterator {
+  public:
+    explicit iterator(uint32_t mask) : mask(mask) {}
+    uint32_t operator*() const { return __builtin_ctz(mask); }
+    iterator &operator++() {
+      mask &= mask - 1;
+      return *this;
+    }
+    bool operator!=(const iterator &other) const { return mask != other.mask; }
+
+  private:
+    uint32_t mask;
+  };
+
+  iterator begin() const { return iterator(mask); }
+  iterator end() const { return iterator(0); }
+
+private:
+  uint32_t mask;
+};
+
+// Sixteen consecutive control bytes compared at once.
+struct Group {
+  static constexpr size_t WIDTH = 16;
+
+#ifdef __SSE2__
+  explicit Group(const ctrl_t *pos)
+      : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos))) {}
+
+  BitMask match(ctrl_t tag) const {
+    return BitMask(static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), ctrl))));
+  }
+  BitMask match_empty() const { return match(CTRL_EMPTY); }
+  BitMask match_empty_or_deleted() const {
+    return BitMask(static_cast<uint32_t>(_mm_movemask_epi8(ctrl)));
+  }
+  BitMask match_full() const {
+    return BitMask(~static_cast<uint32_t>(_mm_movemask_epi8(ctrl)) & 0xFFFF);
+  }
+
+private:
+  __m128i ctrl;
+#else
+  explicit Group(const ctrl_t *pos) {
+    for (size_t i = 0; i < WIDTH; ++i)
+      ctrl[i] = pos[i];
+  }
+
+  BitMask match(ctrl_t tag) const {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < WIDTH; ++i)
+      mask |= static_cast<uint32_t>(ctrl[i] == tag) << i;
+    return BitMask(mask);
+  }
+  BitMask match_empty() const { return match(CTRL_EMPTY); }
+  BitMask match_empty_or_deleted() const {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < WIDTH; ++i)
+      mask |= static_cast<uint32_t>(!is_full(ctrl[i])) << i;
+    return BitMask(mask);
+  }
+  BitMask match_full() const {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < WIDTH; ++i)
+      mask |= static_cast<uint32_t>(is_full(ctrl[i])) << i;
+    return BitMask(mask);
+  }
+
+private:
+  ctrl_t ctrl[WIDTH];
+#endif
+};
@@ -0,0 +1,574 @@
+#pragma once
+#include "open_addressing_hash_table.h"
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Bucketized cuckoo hashing. Each key has two candidate buckets of
+// BucketSize slots, picked by two hash functions, and always sits in one of
+// them. A lookup therefore checks at most 2 * BucketSize slots, whatever the
+// load or the key distribution. Buckets start on a cache line with their tag
+// bytes, so a miss reads two lines and a hit at most one more; when a bucket
+// fits in 64 bytes, any find touches at most two lines.
+//
+// When both buckets of a new key are full, insert runs a breadth-first search
+// for the shortest chain of entries that can each move to their other bucket
+// and that ends at a free slot. It then shifts the chain along by one. If no
+// chain exists within MAX_PATH_BUCKETS buckets, the table doubles. Erase
+// clears the slot and leaves no tombstone.
+//
+// The price is paid on insert: the displacement search, and a lower load
+// before growth than probing (MAX_LOAD) for buckets of one or two slots.
+// Iterators and references are invalidated by every insert.
+template <typename K, typename V, typename HashFunction = std::hash<K>,
+          size_t BucketSize = 4> //
+class CuckooHashTable {
+  static_assert(BucketSize >= 1 && BucketSize <= 16,
+                "CuckooHashTable buckets hold 1 to 16 slots");
+
+public:
+  // Load above which an insert grows the table. Wider buckets leave the
+  // displacement search more room, so they fill further.
+  static constexpr float MAX_LOAD =
+      BucketSize >= 8 ? 0.95f : (BucketSize >= 4 ? 0.9f : 0.5f);
+  // Slots checked by the slowest possible lookup.
+  static constexpr size_t MAX_LOOKUP_SLOTS = 2 * BucketSize;
+  // Buckets the displacement search visits before giving up and growing.
+  static constexpr size_t MAX_PATH_BUCKETS = 128;
+
+  // Usings for STD cointainers
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = Entry<K, V>;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using pointer = value_type *;
+  using const_pointer = const value_type *;
+
+  // Each slot has a tag byte up front: 0 when the slot is free, otherwise 7
+  // bits of the key's hash with the top bit set. Lookups compare keys only
+  // where the tag matches, so a miss reads just the tags of both buckets.
+  struct alignas(64) Bucket {
+    uint8_t tags[BucketSize] = {};
+    Entry<K, V> slots[BucketSize];
+  };
+
+  // Walks the buckets slot by slot, stopping only on OCCUPIED slots.
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = Entry<K, V>;
+    using pointer = value_type *;
+    using reference = value_type &;
+
+    iterator() = default;
+    iterator(Bucket *bucket, size_type slot, Bucket *end)
+        : bucket(bucket), slot(slot), end(end) {
+      skip_empty();
+    }
+
+    iterator operator++() {
+      ++slot;
+      skip_empty();
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator temp = *this;
+      ++*this;
+      return temp;
+    }
+
+    bool operator==(const iterator &other) const {
+      return bucket == other.bucket && slot == other.slot;
+    }
+    bool operator!=(const iterator &other) const { return !(*this == other); }
+
+    reference operator*() const { return bucket->slots[slot]; }
+    pointer operator->() const { return &bucket->slots[slot]; }
+
+  private:
+    Bucket *bucket = nullptr;
+    size_type slot = 0;
+    Bucket *end = nullptr;
+
+    void skip_empty() {
+      while (bucket != end) {
+        if (slot == BucketSize) {
+          ++bucket;
+          slot = 0;
+        } else if (bucket->slots[slot].state != EntryState::OCCUPIED) {
+          ++slot;
+        } else {
+          return;
+        }
+      }
+    }
+  };
+
+  CuckooHashTable() : buckets(2), num_elements(0) {}
+  CuckooHashTable(std::initializer_list<std::pair<const K, V>> init)
+      : CuckooHashTable() {
+    reserve(init.size());
+    for (auto &p : init)
+      insert(p.first, p.second);
+  }
+  CuckooHashTable(const CuckooHashTable &other) = default;
+  CuckooHashTable(CuckooHashTable &&other) : CuckooHashTable() {
+    swap(other);
+  }
+  CuckooHashTable &operator=(CuckooHashTable other) {
+    swap(other);
+    return *this;
+  }
+
+  iterator begin() noexcept { return iterator_at(0); }
+  iterator end() noexcept { return iterator_at(bucket_count()); }
+
+  // Insertions never overwrite: when the key is already present the
+  // returned iterator points at the existing entry and the flag is false.
+  std::pair<iterator, bool> insert(key_type key, mapped_type value);
+  template <typename KeyArg, typename... Args>
+  std::pair<iterator, bool> emplace(KeyArg &&key, Args &&...args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type &key, Args &&...args) {
+    return try_emplace_hashed(key, hasher(key), std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type &&key, Args &&...args) {
+    const size_t hash = hasher(key);
+    return try_emplace_hashed(std::move(key), hash,
+                              std::forward<Args>(args)...);
+  }
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&value) {
+    auto result = try_emplace_hashed(key, hasher(key), std::forward<M>(value));
+    if (!result.second)
+      result.first->value = std::forward<M>(value);
+    return result;
+  }
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&value) {
+    const size_t hash = hasher(key);
+    auto result =
+        try_emplace_hashed(std::move(key), hash, std::forward<M>(value));
+    if (!result.second)
+      result.first->value = std::forward<M>(value);
+    return result;
+  }
+  template <typename InputIt> void bulk_insert(InputIt first, InputIt last);
+  size_type erase(const key_type &key);
+  iterator find(const key_type &key) { return iterator_at(find_index(key)); }
+
+  bool operator==(const CuckooHashTable &other) const;
+  bool operator!=(const CuckooHashTable &other) const {
+    return !(*this == other);
+  }
+
+  mapped_type &operator[](const key_type &key);
+  mapped_type &at(const key_type &key);
+  bool contains(const key_type &key) const {
+    return find_index(key) != bucket_count();
+  }
+
+  // Rounds new_capacity up to whole buckets, a power of two of them, and
+  // never below what the current entries need.
+  void rehash(size_type new_capacity);
+  void reserve(size_type count) {
+    rehash(static_cast<size_type>(count / MAX_LOAD) + 1);
+  }
+
+  size_type size() const noexcept { return num_elements; }
+  bool empty() const noexcept { return num_elements == 0; }
+  // In slots, not buckets.
+  size_type bucket_count() const noexcept {
+    return buckets.size() * BucketSize;
+  }
+  float load_factor() const noexcept {
+    return static_cast<float>(num_elements) / bucket_count();
+  }
+  float max_load_factor() const noexcept { return MAX_LOAD; }
+
+  void clear() noexcept;
+  void swap(CuckooHashTable &other);
+
+  // Heterogeneous lookup, only offered when HashFunction is transparent, as
+  // in OpenAddressingHashTable.
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  iterator find(const Q &key) {
+    return iterator_at(find_index(key, hasher(key)));
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  bool contains(const Q &key) const {
+    return find_index(key, hasher(key)) != bucket_count();
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  mapped_type &at(const Q &key) {
+    size_type index = find_index(key, hasher(key));
+    if (index == bucket_count())
+      throw std::out_of_range("function at(): key was not found");
+    return slot_at(index).value;
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  size_type erase(const Q &key) {
+    return erase_at(find_index(key, hasher(key)));
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  mapped_type &operator[](const Q &key) {
+    return try_emplace_hashed(key, hasher(key)).first->value;
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  std::pair<iterator, bool> insert(const Q &key, mapped_type value) {
+    return try_emplace_hashed(key, hasher(key), std::move(value));
+  }
+
+  std::vector<Bucket> buckets;
+  HashFunction hasher;
+  size_t num_elements;
+
+private:
+  static constexpr size_type NO_PARENT = ~size_type(0);
+  // Doublings an insert may force, beyond growth at MAX_LOAD, before it
+  // decides the key cannot be placed: in practice only more than
+  // MAX_LOOKUP_SLOTS keys with one whole hash get this far.
+  static constexpr int MAX_EXTRA_GROWTH = 3;
+
+  // A bucket reached by the displacement search: the entry in slot `slot`
+  // of the parent bucket has this bucket as its other candidate.
+  struct PathNode {
+    size_type bucket;
+    size_type parent;
+    size_type slot;
+  };
+
+  struct Candidates {
+    size_type first;
+    size_type second;
+    uint8_t tag;
+  };
+
+  // The two candidate buckets and the tag of a hash. All come from one
+  // 64-bit mix of it: the first bucket from the low bits, the second from
+  // bits 32 and up, the tag from the top 7. The buckets differ whenever the
+  // table has more than one.
+  Candidates candidates(size_t hash) const {
+    const size_type mask = buckets.size() - 1;
+    const uint64_t mixed = FinalizerMix()(hash);
+    const size_type first = mixed & mask;
+    size_type second = (mixed >> 32) & mask;
+    if (second == first)
+      second = first ^ (mask & 1);
+    return {first, second, static_cast<uint8_t>(0x80 | (mixed >> 57))};
+  }
+  size_type other_bucket(size_type bucket, const key_type &key) const {
+    Candidates c = candidates(hasher(key));
+    return bucket == c.first ? c.second : c.first;
+  }
+  // First free slot of a bucket, or BucketSize if it is full.
+  size_type free_slot(size_type bucket) const {
+    for (size_type s = 0; s < BucketSize; ++s)
+      if (buckets[bucket].tags[s] == 0)
+        return s;
+    return BucketSize;
+  }
+  // Slot of key in bucket, or BucketSize.
+  template <typename Q>
+  size_type find_in(size_type bucket, uint8_t tag, const Q &key) const {
+    const Bucket &b = buckets[bucket];
+    for (size_type s = 0; s < BucketSize; ++s)
+      if (b.tags[s] == tag && b.slots[s].key == key)
+        return s;
+    return BucketSize;
+  }
+
+  Entry<K, V> &slot_at(size_type index) {
+    return buckets[index / BucketSize].slots[index % BucketSize];
+  }
+  const Entry<K, V> &slot_at(size_type index) const {
+    return buckets[index / BucketSize].slots[index % BucketSize];
+  }
+  iterator iterator_at(size_type index) {
+    Bucket *first = buckets.data();
+    Bucket *last = first + buckets.size();
+    if (index == bucket_count())
+      return iterator(last, 0, last);
+    return iterator(first + index / BucketSize, index % BucketSize, last);
+  }
+
+  // Slot holding key, or bucket_count() if it is absent.
+  template <typename Q> size_type find_index(const Q &key, size_t hash) const;
+  size_type find_index(const key_type &key) const {
+    return find_index(key, hasher(key));
+  }
+  // Stores an entry known to be absent and returns its slot, displacing
+  // others along the shortest free path. Returns bucket_count() and leaves
+  // both the table and entry untouched if there is no such path.
+  size_type place(Entry<K, V> &entry, size_t hash);
+  // Places entries in a table of at least bucket_total buckets, doubling
+  // until they all fit. Entries that fitted together before always fit
+  // again once the table is large enough.
+  void rebuild(std::vector<Entry<K, V>> entries, size_type bucket_total);
+  // Looks key up and, if it is missing, stores key_type(key) together with
+  // mapped_type(args...). Nothing is constructed when the key exists.
+  template <typename KeyArg, typename... Args>
+  std::pair<iterator, bool> try_emplace_hashed(KeyArg &&key, size_t hash,
+                                               Args &&...args);
+  // Empties the slot at index; index may be bucket_count().
+  size_type erase_at(size_type index);
+  // Makes room for one more entry if the load would pass MAX_LOAD.
+  void grow_for_insert() {
+    if (num_elements + 1 > MAX_LOAD * bucket_count())
+      rehash(2 * bucket_count());
+  }
+};
+
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+template <typename Q>
+typename CuckooHashTable<K, V, HashFunction, BucketSize>::size_type
+CuckooHashTable<K, V, HashFunction, BucketSize>::find_index(
+    const Q &key, size_t hash) const {
+  const Candidates c = candidates(hash);
+  size_type slot = find_in(c.first, c.tag, key);
+  if (slot != BucketSize)
+    return c.first * BucketSize + slot;
+  slot = find_in(c.second, c.tag, key);
+  if (slot != BucketSize)
+    return c.second * BucketSize + slot;
+  return bucket_count();
+}
+
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+typename CuckooHashTable<K, V, HashFunction, BucketSize>::size_type
+CuckooHashTable<K, V, HashFunction, BucketSize>::place(Entry<K, V> &entry,
+                                                       size_t hash) {
+  const Candidates c = candidates(hash);
+  PathNode path[MAX_PATH_BUCKETS];
+  size_type count = 0;
+  size_type target = NO_PARENT, target_slot = BucketSize;
+  // Queues a bucket and stops the search if it has a free slot.
+  auto visit = [&](size_type bucket, size_type parent, size_type slot) {
+    path[count] = {bucket, parent, slot};
+    target_slot = free_slot(bucket);
+    if (target_slot != BucketSize)
+      target = count;
+    ++count;
+  };
+
+  visit(c.first, NO_PARENT, 0);
+  if (target == NO_PARENT && c.second != c.first)
+    visit(c.second, NO_PARENT, 0);
+
+  // Breadth-first over buckets, so the chain found is the shortest one. A
+  // bucket already in the tree is not queued twice, which keeps every chain
+  // free of repeated buckets.
+  for (size_type head = 0; head < count && target == NO_PARENT; ++head) {
+    const size_type bucket = path[head].bucket;
+    for (size_type s = 0; s < BucketSize && target == NO_PARENT &&
+                          count < MAX_PATH_BUCKETS;
+         ++s) {
+      const size_type alt = other_bucket(bucket, buckets[bucket].slots[s].key);
+      bool seen = false;
+      for (size_type i = 0; i < count && !seen; ++i)
+        seen = path[i].bucket == alt;
+      if (!seen)
+        visit(alt, head, s);
+    }
+  }
+  if (target == NO_PARENT)
+    return bucket_count();
+
+  // Walk back to the root, moving each entry into the hole below it.
+  size_type node = target, slot = target_slot;
+  while (path[node].parent != NO_PARENT) {
+    const PathNode &from = path[node];
+    Bucket &source = buckets[path[from.parent].bucket];
+    buckets[from.bucket].slots[slot] = std::move(source.slots[from.slot]);
+    buckets[from.bucket].tags[slot] = source.tags[from.slot];
+    node = from.parent;
+    slot = from.slot;
+  }
+
+  Bucket &root = buckets[path[node].bucket];
+  root.slots[slot] = std::move(entry);
+  root.slots[slot].state = EntryState::OCCUPIED;
+  root.tags[slot] = c.tag;
+  num_elements++;
+  return path[node].bucket * BucketSize + slot;
+}
+
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+void CuckooHashTable<K, V, HashFunction, BucketSize>::rebuild(
+    std::vector<Entry<K, V>> entries, size_type bucket_total) {
+  for (;;) {
+    buckets = std::vector<Bucket>(bucket_total);
+    num_elements = 0;
+    size_type placed = 0;
+    while (placed < entries.size() &&
+           place(entries[placed], hasher(entries[placed].key)) !=
+               bucket_count())
+      ++placed;
+    if (placed == entries.size())
+      return;
+
+    // Take everything back out and try again twice as large.
+    std::vector<Entry<K, V>> all;
+    all.reserve(entries.size());
+    for (auto &entry : *this)
+      all.push_back(std::move(entry));
+    for (size_type i = placed; i < entries.size(); ++i)
+      all.push_back(std::move(entries[i]));
+    entries = std::move(all);
+    bucket_total *= 2;
+  }
+}
+
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+std::pair<typename CuckooHashTable<K, V, HashFunction, BucketSize>::iterator,
+          bool>
+CuckooHashTable<K, V, HashFunction, BucketSize>::insert(key_type key,
+                                                        mapped_type value) {
+  const size_t hash = hasher(key);
+  return try_emplace_hashed(std::move(key), hash, std::move(value));
+}
+
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+template <typename KeyArg, typename... Args>
+std::pair<typename CuckooHashTable<K, V, HashFunction, BucketSize>::iterator,
+          bool>
+CuckooHashTable<K, V, HashFunction, BucketSize>::emplace(KeyArg &&key,
+                                                         Args &&...args) {
+  key_type new_key(std::forward<KeyArg>(key));
+  const size_t hash = hasher(new_key);
+  return try_emplace_hashed(std::move(new_key), hash,
+                            std::forward<Args>(args)...);
+}
+
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+template <typename KeyArg, typename... Args>
+std::pair<typename CuckooHashTable<K, V, HashFunction, BucketSize>::iterator,
+          bool>
+CuckooHashTable<K, V, HashFunction, BucketSize>::try_emplace_hashed(
+    KeyArg &&key, size_t hash, Args &&...args) {
+  size_type index = find_index(key, hash);
+  if (index != bucket_count())
+    return {iterator_at(index), false};
+
+  grow_for_insert();
+  Entry<K, V> entry{key_type(std::forward<KeyArg>(key)),
+                    mapped_type(std::forward<Args>(args)...)};
+  for (int growth = 0;; ++growth) {
+    index = place(entry, hash);
+    if (index != bucket_count())
+      return {iterator_at(index), true};
+    if (growth == MAX_EXTRA_GROWTH)
+      throw std::length_error(
+          "insert(): too many keys share both candidate buckets");
+    rehash(2 * bucket_count());
+  }
+}
+
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+template <typename InputIt>
+void CuckooHashTable<K, V, HashFunction, BucketSize>::bulk_insert(
+    InputIt first, InputIt last) {
+  if constexpr (std::is_base_of_v<
+                    std::forward_iterator_tag,
+                    typename std::iterator_traits<InputIt>::iterator_category>)
+    reserve(num_elements + std::distance(first, last));
+  for (; first != last; ++first)
+    insert(first->first, first->second);
+}
+
+/// ================== OPERATORS ================
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+typename CuckooHashTable<K, V, HashFunction, BucketSize>::mapped_type &
+CuckooHashTable<K, V, HashFunction, BucketSize>::operator[](
+    const key_type &key) {
+  return try_emplace_hashed(key, hasher(key)).first->value;
+}
+
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+bool CuckooHashTable<K, V, HashFunction, BucketSize>::operator==(
+    const CuckooHashTable &other) const {
+  if (other.num_elements != num_elements)
+    return false;
+
+  for (const Bucket &bucket : buckets)
+    for (const Entry<K, V> &entry : bucket.slots) {
+      if (entry.state != EntryState::OCCUPIED)
+        continue;
+      size_type index = other.find_index(entry.key);
+      if (index == other.bucket_count() ||
+          other.slot_at(index).value != entry.value)
+        return false;
+    }
+  return true;
+}
+
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+typename CuckooHashTable<K, V, HashFunction, BucketSize>::mapped_type &
+CuckooHashTable<K, V, HashFunction, BucketSize>::at(const key_type &key) {
+  size_type index = find_index(key);
+  if (index == bucket_count())
+    throw std::out_of_range("function at(): key was not found");
+  return slot_at(index).value;
+}
+
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+typename CuckooHashTable<K, V, HashFunction, BucketSize>::size_type
+CuckooHashTable<K, V, HashFunction, BucketSize>::erase(const key_type &key) {
+  return erase_at(find_index(key));
+}
+
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+typename CuckooHashTable<K, V, HashFunction, BucketSize>::size_type
+CuckooHashTable<K, V, HashFunction, BucketSize>::erase_at(size_type index) {
+  if (index == bucket_count())
+    return 0;
+
+  slot_at(index) = Entry<K, V>();
+  buckets[index / BucketSize].tags[index % BucketSize] = 0;
+  --num_elements;
+  return 1;
+}
+
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+void CuckooHashTable<K, V, HashFunction, BucketSize>::rehash(
+    size_type new_capacity) {
+  const size_type needed =
+      static_cast<size_type>(num_elements / MAX_LOAD) + 1;
+  const size_type slots = std::max(new_capacity, needed);
+  size_type bucket_total = 2;
+  while (bucket_total * BucketSize < slots)
+    bucket_total *= 2;
+
+  std::vector<Entry<K, V>> entries;
+  entries.reserve(num_elements);
+  for (auto &entry : *this)
+    entries.push_back(std::move(entry));
+  rebuild(std::move(entries), bucket_total);
+}
+
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+void CuckooHashTable<K, V, HashFunction, BucketSize>::clear() noexcept {
+  for (Bucket &bucket : buckets)
+    bucket = Bucket();
+  num_elements = 0;
+}
+
+template <typename K, typename V, typename HashFunction, size_t BucketSize>
+void CuckooHashTable<K, V, HashFunction, BucketSize>::swap(
+    CuckooHashTable &other) {
+  std::swap(num_elements, other.num_elements);
+  std::swap(hasher, other.hasher);
+  std::swap(buckets, other.buckets);
+}
@@ -0,0 +1,307 @@
+#pragma once
+#include "open_addressing_hash_table.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Immutable map on a minimal perfect hash, in the style of PTHash: n keys
+// fill exactly n slots and every lookup reads one pilot and one slot.
+//
+// Keys are spread over about n / BUCKET_SIZE buckets. Building places the
+// buckets largest first; for each one it searches the pilot p for which
+//   slot(key) = fastrange(mix(h(key) ^ mix(p)), n)
+// sends all of the bucket's keys to distinct free slots. A lookup recomputes
+// the slot from h(key) and the bucket's pilot and compares the one key there,
+// so a miss costs the same as a hit and nothing is ever probed. Pilots take 4
+// bytes per bucket, about 0.8 bytes per key, on top of the key/value array.
+//
+// Build with OpenAddressingHashTable::freeze() or from key/value pairs.
+// Trivially copyable tables can be saved and loaded again without rebuilding.
+template <typename K, typename V> //
+struct FrozenEntry {
+  K key;
+  V value;
+};
+
+constexpr char FROZEN_MAGIC[8] = {'O', 'A', 'H', 'T', 'F', 'R', 'Z', 'N'};
+constexpr uint32_t FROZEN_VERSION = 1;
+constexpr uint32_t FROZEN_BYTE_ORDER = 0x01020304;
+
+struct FrozenHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t size;
+  uint64_t buckets;
+  uint64_t seed;
+  uint32_t hash_id;
+  uint32_t key_size;
+  uint32_t value_size;
+  uint32_t entry_size;
+};
+
+template <typename K, typename V, typename HashFunction = std::hash<K>>
+class FrozenHashTable {
+public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = FrozenEntry<K, V>;
+  using size_type = size_t;
+  using const_iterator = const value_type *;
+
+  // Average keys per bucket. Larger buckets mean fewer pilots but longer
+  // pilot searches.
+  static constexpr size_type BUCKET_SIZE = 5;
+  // Pilots tried for one bucket before the build starts over with a new
+  // seed.
+  static constexpr uint64_t MAX_PILOT = uint64_t(1) << 24;
+
+  FrozenHashTable() = default;
+  // Duplicate keys keep their first value. Throws std::invalid_argument if
+  // two different keys have the same hash, which no pilot can separate.
+  explicit FrozenHashTable(std::vector<std::pair<K, V>> items);
+
+  // Pointer to the value, or nullptr if key is absent.
+  const mapped_type *find(const key_type &key) const {
+    if (entries.empty())
+      return nullptr;
+    size_type index = slot(hasher(key));
+    return entries[index].key == key ? &entries[index].value : nullptr;
+  }
+  bool contains(const key_type &key) const { return find(key) != nullptr; }
+  const mapped_type &at(const key_type &key) const {
+    const mapped_type *value = find(key);
+    if (!value)
+      throw std::out_of_range("function at(): key was not found");
+    return *value;
+  }
+
+  const_iterator begin() const noexcept { return entries.data(); }
+  const_iterator end() const noexcept {
+    return entries.data() + entries.size();
+  }
+
+  size_type size() const noexcept { return entries.size(); }
+  bool empty() const noexcept { return entries.empty(); }
+  size_type bucket_count() const noexcept { return pilots.size(); }
+  // Entry array plus pilots.
+  size_type memory_bytes() const noexcept {
+    return entries.size() * sizeof(value_type) +
+           pilots.size() * sizeof(uint32_t);
+  }
+
+  // Needs trivially copyable K and V; throws std::runtime_error when the file
+  // cannot be written, or read back as a table of this type.
+  void save(const std::string &path) const;
+  static FrozenHashTable load(const std::string &path);
+
+private:
+  std::vector<value_type> entries;
+  std::vector<uint32_t> pilots;
+  uint64_t seed = 0;
+  HashFunction hasher;
+
+  static uint64_t mix(uint64_t x) { return FinalizerMix()(x); }
+  static size_type fastrange(uint64_t x, size_type n) {
+    return static_cast<size_type>((static_cast<__uint128_t>(x) * n) >> 64);
+  }
+  uint64_t key_hash(size_t hash) const { return mix(hash ^ seed); }
+  size_type bucket_of(uint64_t h) const { return fastrange(h, pilots.size()); }
+  size_type slot_of(uint64_t h, uint32_t pilot) const {
+    return fastrange(mix(h ^ (pilot * 0x9E3779B97F4A7C15ULL)), entries.size());
+  }
+  size_type slot(size_t hash) const {
+    uint64_t h = key_hash(hash);
+    return slot_of(h, pilots[bucket_of(h)]);
+  }
+
+  // Places hashes[i] for every i in order; false if a bucket ran out of
+  // pilots. slots receives the slot of every item.
+  bool build(const std::vector<uint64_t> &hashes,
+             std::vector<size_type> &slots);
+};
+
+template <typename K, typename V, typename HashFunction>
+FrozenHashTable<K, V, HashFunction>::FrozenHashTable(
+    std::vector<std::pair<K, V>> items) {
+  if (items.empty())
+    return;
+
+  // Equal keys have equal hashes, so sorting by hash (then by position)
+  // brings duplicates together behind the first of them.
+  std::vector<std::pair<size_t, size_type>> by_hash(items.size());
+  for (size_type i = 0; i < items.size(); ++i)
+    by_hash[i] = {hasher(items[i].first), i};
+  std::sort(by_hash.begin(), by_hash.end());
+  std::vector<size_type> kept;
+  kept.reserve(items.size());
+  for (size_type i = 0; i < by_hash.size();) {
+    const K &key = items[by_hash[i].second].first;
+    size_type j = i + 1;
+    for (; j < by_hash.size() && by_hash[j].first == by_hash[i].first; ++j)
+      if (!(items[by_hash[j].second].first == key))
+        throw std::invalid_argument(
+            "FrozenHashTable: distinct keys with equal hashes");
+    kept.push_back(by_hash[i].second);
+    i = j;
+  }
+
+  entries.resize(kept.size());
+  pilots.resize((kept.size() + BUCKET_SIZE - 1) / BUCKET_SIZE);
+  std::vector<uint64_t> hashes(kept.size());
+  std::vector<size_type> slots;
+  for (seed = 0;; ++seed) {
+    for (size_type i = 0; i < kept.size(); ++i)
+      hashes[i] = key_hash(hasher(items[kept[i]].first));
+    if (build(hashes, slots))
+      break;
+  }
+  for (size_type i = 0; i < kept.size(); ++i) {
+    entries[slots[i]].key = std::move(items[kept[i]].first);
+    entries[slots[i]].value = std::move(items[kept[i]].second);
+  }
+}
+
+template <typename K, typename V, typename HashFunction>
+bool FrozenHashTable<K, V, HashFunction>::build(
+    const std::vector<uint64_t> &hashes, std::vector<size_type> &slots) {
+  const size_type n = hashes.size();
+  const size_type buckets = pilots.size();
+
+  // Items grouped by bucket (counting sort), then buckets by size, largest
+  // first.
+  std::vector<size_type> bucket_begin(buckets + 1, 0);
+  for (uint64_t h : hashes)
+    ++bucket_begin[bucket_of(h) + 1];
+  size_type largest = 0;
+  for (size_type b = 0; b < buckets; ++b) {
+    largest = std::max(largest, bucket_begin[b + 1]);
+    bucket_begin[b + 1] += bucket_begin[b];
+  }
+  std::vector<size_type> members(n);
+  std::vector<size_type> next(bucket_begin.begin(), bucket_begin.end() - 1);
+  for (size_type i = 0; i < n; ++i)
+    members[next[bucket_of(hashes[i])]++] = i;
+
+  std::vector<size_type> by_size(largest + 2, 0);
+  for (size_type b = 0; b < buckets; ++b)
+    ++by_size[largest - (bucket_begin[b + 1] - bucket_begin[b]) + 1];
+  for (size_type s = 1; s < by_size.size(); ++s)
+    by_size[s] += by_size[s - 1];
+  std::vector<size_type> order(buckets);
+  for (size_type b = 0; b < buckets; ++b)
+    order[by_size[largest - (bucket_begin[b + 1] - bucket_begin[b])]++] = b;
+
+  std::vector<bool> taken(n, false);
+  std::vector<size_type> candidate(largest);
+  slots.assign(n, 0);
+  for (size_type b : order) {
+    const size_type first = bucket_begin[b];
+    const size_type count = bucket_begin[b + 1] - first;
+    if (count == 0)
+      break;
+    uint64_t pilot = 0;
+    for (;; ++pilot) {
+      if (pilot == MAX_PILOT)
+        return false;
+      size_type placed = 0;
+      for (; placed < count; ++placed) {
+        size_type s = slot_of(hashes[members[first + placed]],
+                              static_cast<uint32_t>(pilot));
+        if (taken[s])
+          break;
+        taken[s] = true;
+        candidate[placed] = s;
+      }
+      if (placed == count)
+        break;
+      for (size_type i = 0; i < placed; ++i)
+        taken[candidate[i]] = false;
+    }
+    pilots[b] = static_cast<uint32_t>(pilot);
+    for (size_type i = 0; i < count; ++i)
+      slots[members[first + i]] = candidate[i];
+  }
+  return true;
+}
+
+template <typename K, typename V, typename HashFunction>
+void FrozenHashTable<K, V, HashFunction>::save(const std::string &path) const {
+  static_assert(std::is_trivially_copyable_v<K> &&
+                    std::is_trivially_copyable_v<V>,
+                "saved tables need trivially copyable keys and values");
+  FrozenHeader header{};
+  std::memcpy(header.magic, FROZEN_MAGIC, sizeof(header.magic));
+  header.version = FROZEN_VERSION;
+  header.byte_order = FROZEN_BYTE_ORDER;
+  header.size = entries.size();
+  header.buckets = pilots.size();
+  header.seed = seed;
+  header.hash_id = snapshot_id_of<HashFunction>::value;
+  header.key_size = sizeof(K);
+  header.value_size = sizeof(V);
+  header.entry_size = sizeof(value_type);
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(pilots.data()),
+             pilots.size() * sizeof(uint32_t));
+  file.write(reinterpret_cast<const char *>(entries.data()),
+             entries.size() * sizeof(value_type));
+  file.close();
+  if (!file)
+    throw std::runtime_error("save(): cannot write " + path);
+}
+
+template <typename K, typename V, typename HashFunction>
+FrozenHashTable<K, V, HashFunction>
+FrozenHashTable<K, V, HashFunction>::load(const std::string &path) {
+  static_assert(std::is_trivially_copyable_v<K> &&
+                    std::is_trivially_copyable_v<V>,
+                "saved tables need trivially copyable keys and values");
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    throw std::runtime_error("load(): cannot open " + path);
+  FrozenHeader header;
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, FROZEN_MAGIC, sizeof(header.magic)) != 0)
+    throw std::runtime_error("load(): " + path + " is not a frozen table");
+  if (header.version != FROZEN_VERSION ||
+      header.byte_order != FROZEN_BYTE_ORDER ||
+      header.key_size != sizeof(K) || header.value_size != sizeof(V) ||
+      header.entry_size != sizeof(value_type) ||
+      header.hash_id != snapshot_id_of<HashFunction>::value ||
+      header.buckets != (header.size + BUCKET_SIZE - 1) / BUCKET_SIZE)
+    throw std::runtime_error("load(): " + path +
+                             " was saved by a different table type");
+
+  FrozenHashTable table;
+  table.seed = header.seed;
+  table.pilots.resize(header.buckets);
+  table.entries.resize(header.size);
+  file.read(reinterpret_cast<char *>(table.pilots.data()),
+            table.pilots.size() * sizeof(uint32_t));
+  file.read(reinterpret_cast<char *>(table.entries.data()),
+            table.entries.size() * sizeof(value_type));
+  if (!file)
+    throw std::runtime_error("load(): " + path + " is truncated");
+  return table;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+FrozenHashTable<K, V, HashFunction>
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                        GrowthPolicy>::freeze() const {
+  std::vector<std::pair<K, V>> items;
+  items.reserve(num_elements);
+  for (size_type index = 0; index < data.size(); ++index)
+    if (is_full(ctrl[index]))
+      items.emplace_back(data[index].key, data[index].value);
+  return FrozenHashTable<K, V, HashFunction>(std::move(items));
+}
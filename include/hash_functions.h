@@ -3,16 +3,19 @@
 #include <cstdint>
 #include <cstring>
 #include <string>
+#include <string_view>
 
 template <typename T> struct Hash {
   size_t operator()(const T &key) const;
 };
 
 template <> struct Hash<int> {
+  static constexpr uint32_t snapshot_id = 1;
   size_t operator()(int key) const { return key * 2654435761u; }
 };
 
 template <> struct Hash<char> {
+  static constexpr uint32_t snapshot_id = 2;
   size_t operator()(char key) const {
     int hash = static_cast<int>(key << 8);
     hash *= 0xF5;
@@ -21,6 +24,7 @@ template <> struct Hash<char> {
 };
 
 template <> struct Hash<float> {
+  static constexpr uint32_t snapshot_id = 3;
   size_t operator()(float key) const {
     if (key == 0.0f)
       key = 0.0f;
@@ -38,18 +42,34 @@ template <> struct Hash<float> {
     return static_cast<size_t>(bits);
   }
 };
+// Transparent: std::string_view and C strings hash exactly like the
+// std::string holding the same characters, so tables can be probed without
+// building a temporary key.
 template <> struct Hash<std::string> {
+  static constexpr uint32_t snapshot_id = 4;
+  using is_transparent = void;
+
   size_t operator()(const std::string &key) const {
+    return (*this)(std::string_view(key));
+  }
+  size_t operator()(const char *key) const {
+    return (*this)(std::string_view(key));
+  }
+  size_t operator()(std::string_view key) const {
     const uint64_t seed = 0xc70f6907UL;
     const uint64_t m = 0xc6a4a7935bd1e995ULL;
     const int r = 47;
 
     uint64_t h = seed ^ (key.size() * m);
-    const uint64_t *data = (const uint64_t *)key.data();
-    const uint64_t *end = data + (key.size() / 8);
+    // Views may start anywhere inside a buffer, so the blocks are copied out
+    // rather than loaded through a uint64_t pointer.
+    const char *data = key.data();
+    const char *end = data + (key.size() / 8) * 8;
 
     while (data != end) {
-      uint64_t k = *data++;
+      uint64_t k;
+      std::memcpy(&k, data, sizeof(k));
+      data += sizeof(k);
       k *= m;
       k ^= k >> r;
       k *= m;
@@ -61,16 +81,22 @@ template <> struct Hash<std::string> {
     switch (key.size() & 7) {
     case 7:
       h ^= uint64_t(data2[6]) << 48;
+      [[fallthrough]];
     case 6:
       h ^= uint64_t(data2[5]) << 40;
+      [[fallthrough]];
     case 5:
       h ^= uint64_t(data2[4]) << 32;
+      [[fallthrough]];
     case 4:
       h ^= uint64_t(data2[3]) << 24;
+      [[fallthrough]];
     case 3:
       h ^= uint64_t(data2[2]) << 16;
+      [[fallthrough]];
     case 2:
       h ^= uint64_t(data2[1]) << 8;
+      [[fallthrough]];
     case 1:
       h ^= uint64_t(data2[0]);
       h *= m;
@@ -0,0 +1,260 @@
+#pragma once
+#include "open_addressing_hash_table.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Snapshot files written by OpenAddressingHashTable::save(). The layout is the
+// in-memory one, in host byte order: a SnapshotHeader, then the control bytes
+// (capacity + Group::WIDTH - 1), the stored hashes when the hash function is
+// wrapped in StoreHash, and the Entry array, each section starting on a
+// SNAPSHOT_ALIGNMENT boundary so it can be used in place after mmap.
+
+constexpr char SNAPSHOT_MAGIC[8] = {'O', 'A', 'H', 'T', 'S', 'N', 'A', 'P'};
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+constexpr uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+constexpr size_t SNAPSHOT_ALIGNMENT = 64;
+
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t capacity;
+  uint64_t num_elements;
+  uint32_t probing_id;
+  uint32_t hash_id;
+  uint32_t key_size;
+  uint32_t value_size;
+  uint32_t entry_size;
+  uint32_t store_hash;
+  uint64_t reserved;
+};
+static_assert(sizeof(SnapshotHeader) == SNAPSHOT_ALIGNMENT);
+
+struct SnapshotLayout {
+  size_t ctrl_offset;
+  size_t hashes_offset;
+  size_t data_offset;
+  size_t file_size;
+};
+
+inline SnapshotLayout snapshot_layout(size_t capacity, bool store_hash,
+                                      size_t entry_size) {
+  auto align = [](size_t offset) {
+    return (offset + SNAPSHOT_ALIGNMENT - 1) & ~(SNAPSHOT_ALIGNMENT - 1);
+  };
+  SnapshotLayout layout;
+  layout.ctrl_offset = sizeof(SnapshotHeader);
+  layout.hashes_offset =
+      align(layout.ctrl_offset + capacity + Group::WIDTH - 1);
+  size_t hashes_size = store_hash ? capacity * sizeof(size_t) : 0;
+  layout.data_offset = align(layout.hashes_offset + hashes_size);
+  layout.file_size = layout.data_offset + capacity * entry_size;
+  return layout;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+SnapshotHeader make_snapshot_header(size_t capacity, size_t num_elements) {
+  SnapshotHeader header{};
+  std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.byte_order = SNAPSHOT_BYTE_ORDER;
+  header.capacity = capacity;
+  header.num_elements = num_elements;
+  header.probing_id = snapshot_id_of<ProbingPolicy>::value;
+  header.hash_id = snapshot_id_of<HashFunction>::value;
+  header.key_size = sizeof(K);
+  header.value_size = sizeof(V);
+  header.entry_size = sizeof(Entry<K, V>);
+  header.store_hash = stores_hash<HashFunction>::value;
+  return header;
+}
+
+// Lookups straight out of a mapped snapshot: nothing is parsed or rehashed,
+// pages are loaded on first touch and shared between processes mapping the
+// same file. Move-only; the mapping is released on destruction.
+template <typename K, typename V, typename HashFunction = std::hash<K>,
+          typename ProbingPolicy = LinearHashing<K>>
+class MappedOpenAddressingHashTable {
+  static_assert(std::is_trivially_copyable_v<K> &&
+                    std::is_trivially_copyable_v<V>,
+                "snapshots need trivially copyable keys and values");
+
+public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = Entry<K, V>;
+  using size_type = size_t;
+
+  explicit MappedOpenAddressingHashTable(const std::string &path);
+  MappedOpenAddressingHashTable(MappedOpenAddressingHashTable &&other) noexcept
+      : mapping(other.mapping), mapping_size(other.mapping_size),
+        ctrl(other.ctrl), hashes(other.hashes), data(other.data),
+        capacity(other.capacity), num_elements(other.num_elements) {
+    other.mapping = nullptr;
+    other.mapping_size = 0;
+  }
+  MappedOpenAddressingHashTable(const MappedOpenAddressingHashTable &) =
+      delete;
+  void operator=(const MappedOpenAddressingHashTable &) = delete;
+  ~MappedOpenAddressingHashTable() {
+    if (mapping)
+      munmap(mapping, mapping_size);
+  }
+
+  // Pointer to the mapped value, or nullptr if key is absent.
+  const mapped_type *find(const key_type &key) const {
+    size_type index = find_slot<stores_hash<HashFunction>::value>(
+        probe, ctrl, data, hashes, capacity, key, hasher(key));
+    return index == capacity ? nullptr : &data[index].value;
+  }
+  bool contains(const key_type &key) const { return find(key) != nullptr; }
+  const mapped_type &at(const key_type &key) const {
+    const mapped_type *value = find(key);
+    if (!value)
+      throw std::out_of_range("function at(): key was not found");
+    return *value;
+  }
+
+  size_type size() const noexcept { return num_elements; }
+  size_type bucket_count() const noexcept { return capacity; }
+  bool empty() const noexcept { return num_elements == 0; }
+
+private:
+  void *mapping = nullptr;
+  size_t mapping_size = 0;
+  const ctrl_t *ctrl = nullptr;
+  const size_t *hashes = nullptr;
+  const Entry<K, V> *data = nullptr;
+  size_type capacity = 0;
+  size_type num_elements = 0;
+  HashFunction hasher;
+  ProbingPolicy probe;
+
+  void validate(const SnapshotHeader &header, size_t file_size) const;
+};
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+MappedOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::
+    MappedOpenAddressingHashTable(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("map(): cannot open " + path);
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < sizeof(SnapshotHeader)) {
+    close(fd);
+    throw std::runtime_error("map(): " + path + " is not a snapshot");
+  }
+
+  mapping_size = info.st_size;
+  mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    throw std::runtime_error("map(): cannot mmap " + path);
+  }
+
+  const auto *base = static_cast<const unsigned char *>(mapping);
+  const auto &header = *reinterpret_cast<const SnapshotHeader *>(base);
+  try {
+    validate(header, mapping_size);
+  } catch (...) {
+    munmap(mapping, mapping_size);
+    throw;
+  }
+
+  SnapshotLayout layout =
+      snapshot_layout(header.capacity, header.store_hash, header.entry_size);
+  capacity = header.capacity;
+  num_elements = header.num_elements;
+  ctrl = reinterpret_cast<const ctrl_t *>(base + layout.ctrl_offset);
+  hashes = reinterpret_cast<const size_t *>(base + layout.hashes_offset);
+  data = reinterpret_cast<const Entry<K, V> *>(base + layout.data_offset);
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+void MappedOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::validate(
+    const SnapshotHeader &header, size_t file_size) const {
+  const SnapshotHeader expected =
+      make_snapshot_header<K, V, HashFunction, ProbingPolicy>(0, 0);
+  if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0)
+    throw std::runtime_error("map(): not a snapshot file");
+  if (header.version != SNAPSHOT_VERSION)
+    throw std::runtime_error("map(): unsupported snapshot version");
+  if (header.byte_order != SNAPSHOT_BYTE_ORDER)
+    throw std::runtime_error("map(): snapshot has a different byte order");
+  if (header.key_size != expected.key_size ||
+      header.value_size != expected.value_size ||
+      header.entry_size != expected.entry_size ||
+      header.store_hash != expected.store_hash)
+    throw std::runtime_error("map(): snapshot has a different entry layout");
+  if (header.probing_id != expected.probing_id)
+    throw std::runtime_error("map(): snapshot uses another probing policy");
+  if (header.hash_id != expected.hash_id)
+    throw std::runtime_error("map(): snapshot uses another hash function");
+
+  // Only linear probing covers every slot of other capacities.
+  bool power_of_two = header.capacity != 0 &&
+                      (header.capacity & (header.capacity - 1)) == 0;
+  bool valid_capacity =
+      header.capacity != 0 &&
+      (power_of_two || is_linear_probing<ProbingPolicy>::value);
+  if (!valid_capacity || header.num_elements > header.capacity ||
+      snapshot_layout(header.capacity, header.store_hash, header.entry_size)
+              .file_size != file_size)
+    throw std::runtime_error("map(): snapshot is truncated or corrupt");
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::save(
+    const std::string &path) const {
+  static_assert(std::is_trivially_copyable_v<K> &&
+                    std::is_trivially_copyable_v<V>,
+                "snapshots need trivially copyable keys and values");
+
+  const size_t capacity = data.size();
+  SnapshotHeader header =
+      make_snapshot_header<K, V, HashFunction, ProbingPolicy>(capacity,
+                                                              num_elements);
+  SnapshotLayout layout =
+      snapshot_layout(capacity, STORE_HASH, sizeof(Entry<K, V>));
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  auto write_at = [&file](size_t offset, const void *bytes, size_t size) {
+    static const char padding[SNAPSHOT_ALIGNMENT] = {};
+    if (!file)
+      return;
+    size_t position = static_cast<size_t>(file.tellp());
+    file.write(padding, offset - position);
+    file.write(static_cast<const char *>(bytes), size);
+  };
+  write_at(0, &header, sizeof(header));
+  write_at(layout.ctrl_offset, ctrl.data(), ctrl.size());
+  if constexpr (STORE_HASH)
+    write_at(layout.hashes_offset, hashes.data(), capacity * sizeof(size_t));
+  write_at(layout.data_offset, data.data(), capacity * sizeof(Entry<K, V>));
+
+  file.close();
+  if (!file)
+    throw std::runtime_error("save(): cannot write " + path);
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+MappedOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                        GrowthPolicy>::map(
+    const std::string &path) {
+  return MappedOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>(
+      path);
+}
@@ -0,0 +1,187 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+// Runtime telemetry for OpenAddressingHashTable and the tables built on it.
+//
+// A table only records while a HashTableTelemetry is attached with
+// set_telemetry(); without one every operation pays a single null check, so
+// the hooks stay compiled into release builds. With one attached, 1 in
+// sample_interval lookups and inserts is measured (sampling is per thread)
+// and every rehash is timed. All counters are relaxed atomics, so one object
+// may be shared by tables used from several threads, such as the shards of
+// a ConcurrentOpenAddressingHashTable.
+//
+// Probe lengths count the slots a lookup or insert examined, 1 meaning the
+// home slot. Unlike the HASH_TABLE_STATISTIC totals they are kept as
+// histograms, split by outcome.
+
+// Probe lengths in power-of-two buckets: bucket 0 counts length 1, bucket b
+// counts lengths in (2^(b-1), 2^b], and the last bucket everything longer.
+struct ProbeHistogram {
+  static constexpr size_t BUCKETS = 16;
+
+  uint64_t counts[BUCKETS] = {};
+  uint64_t samples = 0;
+  uint64_t total_probes = 0;
+  uint64_t max_probes = 0;
+
+  static size_t bucket_for(size_t probes) {
+    size_t bucket = 0;
+    while (bucket + 1 < BUCKETS && (size_t(1) << bucket) < probes)
+      ++bucket;
+    return bucket;
+  }
+
+  double mean() const {
+    return samples == 0 ? 0.0 : static_cast<double>(total_probes) / samples;
+  }
+  // Upper bound of the bucket holding the given quantile (0..1), capped at
+  // the longest probe seen.
+  uint64_t quantile(double q) const {
+    uint64_t seen = 0;
+    for (size_t b = 0; b < BUCKETS; ++b) {
+      seen += counts[b];
+      if (samples != 0 && seen >= q * samples)
+        return std::min<uint64_t>(uint64_t(1) << b, max_probes);
+    }
+    return max_probes;
+  }
+};
+
+struct TelemetrySnapshot {
+  ProbeHistogram find_hit;
+  ProbeHistogram find_miss;
+  ProbeHistogram insert;
+
+  uint64_t rehashes = 0;
+  uint64_t rehash_total_ns = 0;
+  uint64_t rehash_max_ns = 0;
+
+  // State of the table the snapshot was taken from.
+  size_t size = 0;
+  size_t capacity = 0;
+  size_t tombstones = 0;
+  float load_factor = 0.0f;
+  float tombstone_ratio = 0.0f;
+};
+
+// Per thread, shared by all telemetry objects; only decides when to sample.
+inline thread_local uint32_t telemetry_countdown = 0;
+
+class HashTableTelemetry {
+public:
+  // Records 1 in sample_interval lookups and inserts (1: all of them).
+  explicit HashTableTelemetry(uint32_t sample_interval = 64)
+      : interval(sample_interval == 0 ? 1 : sample_interval) {}
+  HashTableTelemetry(const HashTableTelemetry &) = delete;
+  void operator=(const HashTableTelemetry &) = delete;
+
+  bool sample() const {
+    if (telemetry_countdown == 0 || telemetry_countdown > interval)
+      telemetry_countdown = interval;
+    if (--telemetry_countdown != 0)
+      return false;
+    telemetry_countdown = interval;
+    return true;
+  }
+
+  void record_find(size_t probes, bool hit) {
+    record(hit ? find_hit : find_miss, probes);
+  }
+  void record_insert(size_t probes) { record(insert, probes); }
+  void record_rehash(std::chrono::nanoseconds duration) {
+    uint64_t ns = static_cast<uint64_t>(duration.count());
+    rehashes.fetch_add(1, std::memory_order_relaxed);
+    rehash_total_ns.fetch_add(ns, std::memory_order_relaxed);
+    raise(rehash_max_ns, ns);
+  }
+
+  // Everything recorded so far; the table fields are left zero.
+  TelemetrySnapshot snapshot() const {
+    TelemetrySnapshot result;
+    copy(find_hit, result.find_hit);
+    copy(find_miss, result.find_miss);
+    copy(insert, result.insert);
+    result.rehashes = rehashes.load(std::memory_order_relaxed);
+    result.rehash_total_ns = rehash_total_ns.load(std::memory_order_relaxed);
+    result.rehash_max_ns = rehash_max_ns.load(std::memory_order_relaxed);
+    return result;
+  }
+
+  void reset() {
+    for (Histogram *histogram : {&find_hit, &find_miss, &insert}) {
+      for (auto &count : histogram->counts)
+        count.store(0, std::memory_order_relaxed);
+      histogram->samples.store(0, std::memory_order_relaxed);
+      histogram->total_probes.store(0, std::memory_order_relaxed);
+      histogram->max_probes.store(0, std::memory_order_relaxed);
+    }
+    rehashes.store(0, std::memory_order_relaxed);
+    rehash_total_ns.store(0, std::memory_order_relaxed);
+    rehash_max_ns.store(0, std::memory_order_relaxed);
+  }
+
+  uint32_t sample_interval() const noexcept { return interval; }
+
+private:
+  struct Histogram {
+    std::atomic<uint64_t> counts[ProbeHistogram::BUCKETS] = {};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> total_probes{0};
+    std::atomic<uint64_t> max_probes{0};
+  };
+
+  static void raise(std::atomic<uint64_t> &maximum, uint64_t value) {
+    uint64_t current = maximum.load(std::memory_order_relaxed);
+    while (current < value &&
+           !maximum.compare_exchange_weak(current, value,
+                                          std::memory_order_relaxed))
+      ;
+  }
+
+  static void record(Histogram &histogram, size_t probes) {
+    histogram.counts[ProbeHistogram::bucket_for(probes)].fetch_add(
+        1, std::memory_order_relaxed);
+    histogram.samples.fetch_add(1, std::memory_order_relaxed);
+    histogram.total_probes.fetch_add(probes, std::memory_order_relaxed);
+    raise(histogram.max_probes, probes);
+  }
+
+  static void copy(const Histogram &from, ProbeHistogram &to) {
+    for (size_t b = 0; b < ProbeHistogram::BUCKETS; ++b)
+      to.counts[b] = from.counts[b].load(std::memory_order_relaxed);
+    to.samples = from.samples.load(std::memory_order_relaxed);
+    to.total_probes = from.total_probes.load(std::memory_order_relaxed);
+    to.max_probes = from.max_probes.load(std::memory_order_relaxed);
+  }
+
+  const uint32_t interval;
+  Histogram find_hit, find_miss, insert;
+  std::atomic<uint64_t> rehashes{0};
+  std::atomic<uint64_t> rehash_total_ns{0};
+  std::atomic<uint64_t> rehash_max_ns{0};
+};
+
+// Times a rehash into telemetry, if there is one, when it goes out of scope.
+class RehashTimer {
+public:
+  explicit RehashTimer(HashTableTelemetry *telemetry) : telemetry(telemetry) {
+    if (telemetry)
+      start = std::chrono::steady_clock::now();
+  }
+  ~RehashTimer() {
+    if (telemetry)
+      telemetry->record_rehash(std::chrono::steady_clock::now() - start);
+  }
+  RehashTimer(const RehashTimer &) = delete;
+  void operator=(const RehashTimer &) = delete;
+
+private:
+  HashTableTelemetry *telemetry;
+  std::chrono::steady_clock::time_point start;
+};
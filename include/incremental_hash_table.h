@@ -0,0 +1,408 @@
+#pragma once
+#include "open_addressing_hash_table.h"
+
+// OpenAddressingHashTable that never rehashes in one go. Once the table is
+// half way to max_load_factor() (or max_tombstone_factor()) the next slot
+// array is built a few slots per call. When the factor is crossed that array
+// becomes the active table and the old one is kept alive: every mutating call
+// moves at most MIGRATION_STEP old slots across, and lookups check both tables
+// until the old one is drained. A single insert therefore does a bounded
+// amount of work regardless of the table size.
+//
+// The next array is sized so that the active table stays under
+// max_load_factor() for the whole migration, including the inserts made
+// meanwhile; a tombstone cleanup keeps the capacity only when that holds.
+// If a factor is crossed before the array is ready (say, just after
+// max_load_factor() was lowered), the active table takes the overflow until
+// it is: the inner tables run with a load ceiling halfway between
+// max_load_factor() and full, so they never grow on their own.
+template <typename K, typename V, typename HashFunction = std::hash<K>,
+          typename ProbingPolicy = LinearHashing<K>> //
+class IncrementalHashTable {
+public:
+  using table_type = OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>;
+
+  // Old slots visited per mutating call. Must be at least 2 so the old table
+  // is drained before the new one (twice as large) reaches its max load.
+  static constexpr size_t MIGRATION_STEP = 16;
+  // Slots of the next array constructed per mutating call. Building 2x the
+  // capacity while the load goes from LOAD_FACTOR / 2 to LOAD_FACTOR needs
+  // about 6 per insert.
+  static constexpr size_t PREPARE_STEP = 4 * MIGRATION_STEP;
+
+  // Usings for STD cointainers
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = Entry<K, V>;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using pointer = value_type *;
+  using const_pointer = const value_type *;
+
+  // Walks the not yet migrated part of the old table, then the active one.
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = Entry<K, V>;
+    using pointer = value_type *;
+    using reference = value_type &;
+
+    iterator(typename table_type::iterator current,
+             typename table_type::iterator current_end,
+             typename table_type::iterator next,
+             typename table_type::iterator next_end)
+        : current(current), current_end(current_end), next(next),
+          next_end(next_end) {
+      skip_finished();
+    }
+
+    iterator operator++() {
+      ++current;
+      skip_finished();
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator temp = *this;
+      ++*this;
+      return temp;
+    }
+
+    bool operator==(const iterator &other) const {
+      return current == other.current;
+    }
+    bool operator!=(const iterator &other) const { return !(*this == other); }
+
+    reference operator*() const { return *current; }
+    pointer operator->() const { return &*current; }
+
+  private:
+    typename table_type::iterator current;
+    typename table_type::iterator current_end;
+    typename table_type::iterator next;
+    typename table_type::iterator next_end;
+
+    void skip_finished() {
+      if (current == current_end && current != next_end) {
+        current = next;
+        current_end = next_end;
+      }
+    }
+  };
+
+  IncrementalHashTable() { active.max_load = ceiling(max_load); }
+  IncrementalHashTable(std::initializer_list<std::pair<const K, V>> init)
+      : IncrementalHashTable() {
+    for (auto &p : init)
+      insert(p.first, p.second);
+  }
+
+  iterator begin() noexcept {
+    if (!is_rehashing())
+      return iterator(active.begin(), active.end(), active.end(),
+                      active.end());
+    return iterator(old.begin(), old.end(), active.begin(), active.end());
+  }
+  iterator end() noexcept {
+    return iterator(active.end(), active.end(), active.end(), active.end());
+  }
+
+  std::pair<iterator, bool> insert(key_type key, mapped_type value);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type key, Args &&...args);
+  size_type erase(const key_type &key);
+  iterator find(const key_type &key);
+
+  mapped_type &operator[](const key_type &key) {
+    return try_emplace(key).first->value;
+  }
+  mapped_type &at(const key_type &key);
+  bool contains(const key_type &key) const {
+    return active.contains(key) || (is_rehashing() && old.contains(key));
+  }
+
+  size_type size() const noexcept { return active.size() + old.size(); }
+  bool empty() const noexcept { return size() == 0; }
+  size_type bucket_count() const noexcept { return active.bucket_count(); }
+  // As in OpenAddressingHashTable, except that crossing either factor
+  // starts an incremental migration instead of rehashing on the spot.
+  float max_load_factor() const noexcept { return max_load; }
+  void max_load_factor(float factor);
+  float max_tombstone_factor() const noexcept { return max_tombstones; }
+  void max_tombstone_factor(float factor);
+
+  void clear() noexcept;
+
+  // True while entries are still being moved out of the previous table.
+  bool is_rehashing() const noexcept { return migrating; }
+  // Moves everything that is left in one call.
+  void finish_rehash();
+
+private:
+  table_type active;
+  table_type old;
+  float max_load = LOAD_FACTOR;
+  float max_tombstones = DELETE_FACTOR;
+  bool migrating = false;
+  size_type cursor = 0;
+  // Slot arrays of drained tables (and of abandoned preparations), destroyed
+  // MIGRATION_STEP entries at a time so freeing them is not one long pause
+  // either.
+  std::vector<std::vector<Entry<K, V>>> retired;
+  // Storage of the next table, reserved up front and constructed
+  // PREPARE_STEP slots at a time; next_capacity is 0 when nothing is
+  // being prepared.
+  size_type next_capacity = 0;
+  std::vector<Entry<K, V>> next_data;
+  std::vector<ctrl_t> next_ctrl;
+  std::vector<size_t> next_hashes;
+
+  iterator wrap(typename table_type::iterator it) {
+    return iterator(it, active.end(), active.end(), active.end());
+  }
+  iterator wrap_old(typename table_type::iterator it) {
+    return iterator(it, old.end(), active.begin(), active.end());
+  }
+
+  // Load at which the inner tables would grow on their own.
+  static float ceiling(float factor) { return factor + (1.0f - factor) / 2; }
+  // Smallest doubling of the capacity that stays under max_load with count
+  // entries plus one insert per call of a migration out of this table.
+  size_type capacity_for(size_type count) const {
+    size_type capacity = active.bucket_count();
+    size_type margin = capacity / MIGRATION_STEP + 1;
+    size_type next = capacity;
+    while (static_cast<float>(count + margin) > max_load * next)
+      next *= 2;
+    return next;
+  }
+
+  void step();
+  void prepare(size_type new_capacity);
+  bool prepare_step(size_type slots);
+  void start_rehash();
+  void reserve_for_insert();
+};
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+void IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::prepare(
+    size_type new_capacity) {
+  next_capacity = new_capacity;
+  if (!next_data.empty())
+    retired.push_back(std::move(next_data));
+  next_data.clear();
+  next_data.reserve(new_capacity);
+  next_ctrl.clear();
+  next_ctrl.reserve(new_capacity + Group::WIDTH - 1);
+  next_hashes.clear();
+  if constexpr (stores_hash<HashFunction>::value)
+    next_hashes.reserve(new_capacity);
+}
+
+// Constructs up to slots more slots of the next table; true once complete.
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+bool IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::prepare_step(
+    size_type slots) {
+  size_type built = std::min(next_data.size() + slots, next_capacity);
+  next_data.resize(built);
+  next_ctrl.resize(built, CTRL_EMPTY);
+  if constexpr (stores_hash<HashFunction>::value)
+    next_hashes.resize(built, 0);
+
+  if (built < next_capacity)
+    return false;
+  next_ctrl.resize(next_capacity + Group::WIDTH - 1, CTRL_EMPTY);
+  return true;
+}
+
+// Swaps in the next table, which must be fully prepared.
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+void IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::start_rehash() {
+  // Hand the prepared arrays to an empty table; they already have the
+  // layout rehash() would have produced.
+  table_type fresh;
+  fresh.max_load = ceiling(max_load);
+  fresh.max_tombstones = max_tombstones;
+  fresh.data = std::move(next_data);
+  fresh.ctrl = std::move(next_ctrl);
+  fresh.hashes = std::move(next_hashes);
+  next_capacity = 0;
+
+  old = std::move(active);
+  active = std::move(fresh);
+  migrating = true;
+  cursor = 0;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+void IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::step() {
+  for (size_type i = 0; i < MIGRATION_STEP && !retired.empty(); ++i) {
+    if (retired.back().empty())
+      retired.pop_back();
+    else
+      retired.back().pop_back();
+  }
+  if (next_capacity != 0)
+    prepare_step(PREPARE_STEP);
+
+  if (!migrating)
+    return;
+
+  size_type stop = std::min(cursor + MIGRATION_STEP, old.data.size());
+  for (; cursor < stop; ++cursor) {
+    if (!is_full(old.ctrl[cursor]))
+      continue;
+    Entry<K, V> &entry = old.data[cursor];
+    active.try_emplace(std::move(entry.key), std::move(entry.value));
+    old.erase(typename table_type::iterator(&entry, &entry + 1,
+                                            old.ctrl.data() + cursor));
+  }
+
+  if (cursor == old.data.size()) {
+    migrating = false;
+    retired.push_back(std::move(old.data));
+    old = table_type();
+  }
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+void IncrementalHashTable<K, V, HashFunction,
+                          ProbingPolicy>::reserve_for_insert() {
+  if (migrating)
+    return;
+  const size_type capacity = active.bucket_count();
+  const size_type count = active.size() + 1;
+  const float load = static_cast<float>(count) / capacity;
+  const float tombstones = static_cast<float>(active.num_deleted) / capacity;
+
+  if (load > max_load || tombstones > max_tombstones) {
+    // Normally the next array is ready by now. If not, the active table
+    // takes this insert and the next few while it is finished.
+    size_type target = capacity_for(count);
+    if (next_capacity < target)
+      prepare(target);
+    if (prepare_step(PREPARE_STEP))
+      start_rehash();
+    return;
+  }
+
+  // Past half way to either trigger: size the next array for the moment it
+  // fires, assuming the load keeps rising to max_load.
+  size_type target = 0;
+  if (load > max_load / 2)
+    target = capacity_for(static_cast<size_type>(max_load * capacity));
+  else if (tombstones > max_tombstones / 2)
+    target = capacity_for(count);
+  if (next_capacity < target)
+    prepare(target);
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+std::pair<typename IncrementalHashTable<K, V, HashFunction,
+                                        ProbingPolicy>::iterator,
+          bool>
+IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::insert(
+    key_type key, mapped_type value) {
+  return try_emplace(std::move(key), std::move(value));
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+template <typename... Args>
+std::pair<typename IncrementalHashTable<K, V, HashFunction,
+                                        ProbingPolicy>::iterator,
+          bool>
+IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::try_emplace(
+    key_type key, Args &&...args) {
+  step();
+  if (migrating) {
+    auto it = old.find(key);
+    if (it != old.end())
+      return {wrap_old(it), false};
+  }
+
+  reserve_for_insert();
+  auto result = active.try_emplace(std::move(key), std::forward<Args>(args)...);
+  return {wrap(result.first), result.second};
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+typename IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::size_type
+IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::erase(
+    const key_type &key) {
+  step();
+  auto it = active.find(key);
+  if (it != active.end()) {
+    active.erase(it);
+    return 1;
+  }
+  if (migrating) {
+    it = old.find(key);
+    if (it != old.end()) {
+      old.erase(it);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+typename IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::iterator
+IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::find(
+    const key_type &key) {
+  auto it = active.find(key);
+  if (it != active.end())
+    return wrap(it);
+  if (migrating) {
+    it = old.find(key);
+    if (it != old.end())
+      return wrap_old(it);
+  }
+  return end();
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+typename IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::mapped_type &
+IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::at(
+    const key_type &key) {
+  iterator it = find(key);
+  if (it == end())
+    throw std::out_of_range("function at(): key was not found");
+  return it->value;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+void IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::clear() noexcept {
+  active.clear();
+  old = table_type();
+  migrating = false;
+  cursor = 0;
+  next_capacity = 0;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+void IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::finish_rehash() {
+  while (migrating)
+    step();
+  retired.clear();
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+void IncrementalHashTable<K, V, HashFunction, ProbingPolicy>::max_load_factor(
+    float factor) {
+  if (!(factor > 0.0f && factor < 1.0f))
+    throw std::invalid_argument("max_load_factor(): must be in (0, 1)");
+  max_load = factor;
+  // Never below the current load: the active table takes the overflow until
+  // the next one is ready.
+  active.max_load = std::max(active.max_load, ceiling(factor));
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
+void IncrementalHashTable<K, V, HashFunction,
+                          ProbingPolicy>::max_tombstone_factor(float factor) {
+  if (!(factor > 0.0f && factor < 1.0f))
+    throw std::invalid_argument("max_tombstone_factor(): must be in (0, 1)");
+  max_tombstones = factor;
+}
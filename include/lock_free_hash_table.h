@@ -0,0 +1,310 @@
+#pragma once
+#include "open_addressing_hash_table.h"
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <optional>
+
+// Lock-free map for integer keys and values, aimed at many-writer counters.
+//
+// Each slot is an atomic key and an atomic value. A key is claimed once with
+// a CAS on the key word and never changes afterwards; values are updated with
+// CAS loops, so fetch_add never loses an increment. Lookups never write and
+// finish in a bounded number of probes.
+//
+// Growth is cooperative: when a table passes MAX_LOAD a table twice the size
+// is linked behind it, and every mutating call migrates one chunk of slots
+// before doing its own work. Migrating a slot copies its value into the new
+// table and then CASes the old value to MOVED, retrying if a writer got in
+// first, so writers never block. Readers and writers that meet a MOVED value
+// (or a frozen empty slot) continue in the next table. Drained tables stay
+// allocated until the map is destroyed, since a reader may still be in them.
+//
+// Reserved values: empty_key can never be stored as a key, and the two
+// lowest values of V (MOVED and ABSENT) can never be stored as values.
+template <typename K, typename V, typename HashFunction = std::hash<K>>
+class LockFreeHashTable {
+  static_assert(std::is_integral_v<K> && std::is_integral_v<V>,
+                "LockFreeHashTable stores integral keys and values");
+
+public:
+  using key_type = K;
+  using mapped_type = V;
+  using size_type = size_t;
+
+  static constexpr float MAX_LOAD = 0.5f;
+  static constexpr size_type MIGRATION_CHUNK = 256;
+
+  explicit LockFreeHashTable(size_type capacity = 64,
+                             K empty_key = std::numeric_limits<K>::max());
+  ~LockFreeHashTable();
+  LockFreeHashTable(const LockFreeHashTable &) = delete;
+  void operator=(const LockFreeHashTable &) = delete;
+
+  // Stores value unless the key already has one; true if it was stored.
+  bool insert(K key, V value);
+  void insert_or_assign(K key, V value);
+  // Adds delta to the key's value (a missing key counts as 0) and returns
+  // the previous value.
+  V fetch_add(K key, V delta);
+
+  std::optional<V> find(K key) const;
+  bool contains(K key) const { return find(key).has_value(); }
+
+  // Number of keys holding a value. Exact once concurrent writers finish.
+  size_type size() const noexcept {
+    return num_elements.load(std::memory_order_relaxed);
+  }
+  bool empty() const noexcept { return size() == 0; }
+  size_type bucket_count() const noexcept {
+    return current.load(std::memory_order_acquire)->capacity;
+  }
+
+private:
+  static constexpr V MOVED = std::numeric_limits<V>::min();
+  static constexpr V ABSENT = std::numeric_limits<V>::min() + 1;
+
+  struct Slot {
+    std::atomic<K> key;
+    std::atomic<V> value;
+  };
+
+  struct Table {
+    explicit Table(size_type capacity, K empty_key)
+        : capacity(capacity), slots(new Slot[capacity]) {
+      for (size_type i = 0; i < capacity; ++i) {
+        slots[i].key.store(empty_key, std::memory_order_relaxed);
+        slots[i].value.store(ABSENT, std::memory_order_relaxed);
+      }
+    }
+
+    const size_type capacity;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<size_type> used{0};
+    std::atomic<Table *> next{nullptr};
+    std::atomic<size_type> migrate_cursor{0};
+    std::atomic<size_type> migrated{0};
+  };
+
+  Table *root;
+  std::atomic<Table *> current;
+  std::atomic<size_type> num_elements{0};
+  const K empty_key;
+  HashFunction hasher;
+
+  Table *active_table();
+  Table *start_migration(Table *table);
+  void help_migrate(Table *table);
+  void migrate_slot(Table *table, Slot &slot);
+
+  // Slot holding key in table, claiming a free one if claim is set. nullptr
+  // means the key belongs to table->next.
+  Slot *locate(Table *table, K key, size_t hash, bool claim);
+
+  // Runs update(previous, desired) on the key's value until its CAS succeeds
+  // or update returns false. Returns the value update last saw.
+  template <typename Update>
+  V apply(Table *table, K key, size_t hash, bool counted, Update update);
+};
+
+template <typename K, typename V, typename HashFunction>
+LockFreeHashTable<K, V, HashFunction>::LockFreeHashTable(size_type capacity,
+                                                        K empty_key)
+    : empty_key(empty_key) {
+  size_type rounded = 16;
+  while (rounded < capacity)
+    rounded *= 2;
+  root = new Table(rounded, empty_key);
+  current.store(root, std::memory_order_release);
+}
+
+template <typename K, typename V, typename HashFunction>
+LockFreeHashTable<K, V, HashFunction>::~LockFreeHashTable() {
+  while (root) {
+    Table *next = root->next.load(std::memory_order_acquire);
+    delete root;
+    root = next;
+  }
+}
+
+template <typename K, typename V, typename HashFunction>
+typename LockFreeHashTable<K, V, HashFunction>::Table *
+LockFreeHashTable<K, V, HashFunction>::active_table() {
+  Table *table = current.load(std::memory_order_acquire);
+  if (table->next.load(std::memory_order_acquire))
+    help_migrate(table);
+  return table;
+}
+
+template <typename K, typename V, typename HashFunction>
+typename LockFreeHashTable<K, V, HashFunction>::Table *
+LockFreeHashTable<K, V, HashFunction>::start_migration(Table *table) {
+  Table *next = table->next.load(std::memory_order_acquire);
+  if (next)
+    return next;
+
+  Table *fresh = new Table(table->capacity * 2, empty_key);
+  if (table->next.compare_exchange_strong(next, fresh,
+                                          std::memory_order_acq_rel))
+    return fresh;
+  delete fresh;
+  return next;
+}
+
+template <typename K, typename V, typename HashFunction>
+void LockFreeHashTable<K, V, HashFunction>::help_migrate(Table *table) {
+  size_type begin = table->migrate_cursor.fetch_add(
+      MIGRATION_CHUNK, std::memory_order_relaxed);
+  if (begin >= table->capacity)
+    return;
+
+  size_type end = std::min(begin + MIGRATION_CHUNK, table->capacity);
+  for (size_type i = begin; i < end; ++i)
+    migrate_slot(table, table->slots[i]);
+
+  size_type done = table->migrated.fetch_add(end - begin,
+                                             std::memory_order_acq_rel) +
+                   (end - begin);
+  if (done == table->capacity) {
+    Table *expected = table;
+    current.compare_exchange_strong(
+        expected, table->next.load(std::memory_order_acquire),
+        std::memory_order_acq_rel);
+  }
+}
+
+template <typename K, typename V, typename HashFunction>
+void LockFreeHashTable<K, V, HashFunction>::migrate_slot(Table *table,
+                                                         Slot &slot) {
+  Table *next = table->next.load(std::memory_order_acquire);
+  V value = slot.value.load(std::memory_order_acquire);
+  while (value != MOVED) {
+    // Copy first, freeze second: a slot reads MOVED only once the next table
+    // already holds its final value.
+    K key = slot.key.load(std::memory_order_acquire);
+    if (key != empty_key && value != ABSENT) {
+      V copy = value;
+      apply(next, key, hasher(key), false, [copy](V, V &desired) {
+        desired = copy;
+        return true;
+      });
+    }
+    if (slot.value.compare_exchange_weak(value, MOVED,
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_acquire))
+      break;
+  }
+}
+
+template <typename K, typename V, typename HashFunction>
+typename LockFreeHashTable<K, V, HashFunction>::Slot *
+LockFreeHashTable<K, V, HashFunction>::locate(Table *table, K key,
+                                              size_t hash, bool claim) {
+  const size_type mask = table->capacity - 1;
+  for (size_type i = 0; i < table->capacity; ++i) {
+    Slot &slot = table->slots[(hash + i) & mask];
+    K seen = slot.key.load(std::memory_order_acquire);
+    if (seen == key)
+      return &slot;
+    if (seen != empty_key)
+      continue;
+
+    // A frozen empty slot ends the probe sequence in this table.
+    if (!claim || slot.value.load(std::memory_order_acquire) == MOVED)
+      return nullptr;
+    if (slot.key.compare_exchange_strong(seen, key,
+                                         std::memory_order_acq_rel)) {
+      size_type used =
+          table->used.fetch_add(1, std::memory_order_relaxed) + 1;
+      if (used > table->capacity * MAX_LOAD)
+        start_migration(table);
+      return &slot;
+    }
+    if (seen == key)
+      return &slot;
+  }
+
+  if (claim)
+    start_migration(table);
+  return nullptr;
+}
+
+template <typename K, typename V, typename HashFunction>
+template <typename Update>
+V LockFreeHashTable<K, V, HashFunction>::apply(Table *table, K key,
+                                               size_t hash, bool counted,
+                                               Update update) {
+  while (true) {
+    Slot *slot = locate(table, key, hash, true);
+    if (slot) {
+      V previous = slot->value.load(std::memory_order_acquire);
+      V desired;
+      while (previous != MOVED) {
+        if (!update(previous, desired))
+          return previous;
+        if (slot->value.compare_exchange_weak(previous, desired,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire)) {
+          if (counted && previous == ABSENT)
+            num_elements.fetch_add(1, std::memory_order_relaxed);
+          return previous;
+        }
+      }
+    }
+    table = start_migration(table);
+  }
+}
+
+template <typename K, typename V, typename HashFunction>
+bool LockFreeHashTable<K, V, HashFunction>::insert(K key, V value) {
+  V previous = apply(active_table(), key, hasher(key), true,
+                     [value](V previous, V &desired) {
+                       desired = value;
+                       return previous == ABSENT;
+                     });
+  return previous == ABSENT;
+}
+
+template <typename K, typename V, typename HashFunction>
+void LockFreeHashTable<K, V, HashFunction>::insert_or_assign(K key, V value) {
+  apply(active_table(), key, hasher(key), true, [value](V, V &desired) {
+    desired = value;
+    return true;
+  });
+}
+
+template <typename K, typename V, typename HashFunction>
+V LockFreeHashTable<K, V, HashFunction>::fetch_add(K key, V delta) {
+  V previous = apply(active_table(), key, hasher(key), true,
+                     [delta](V previous, V &desired) {
+                       desired = previous == ABSENT ? delta : previous + delta;
+                       return true;
+                     });
+  return previous == ABSENT ? V{} : previous;
+}
+
+template <typename K, typename V, typename HashFunction>
+std::optional<V> LockFreeHashTable<K, V, HashFunction>::find(K key) const {
+  size_t hash = hasher(key);
+  Table *table = current.load(std::memory_order_acquire);
+  while (table) {
+    const size_type mask = table->capacity - 1;
+    for (size_type i = 0; i < table->capacity; ++i) {
+      Slot &slot = table->slots[(hash + i) & mask];
+      K seen = slot.key.load(std::memory_order_acquire);
+      if (seen != key && seen != empty_key)
+        continue;
+
+      V value = slot.value.load(std::memory_order_acquire);
+      if (value == MOVED)
+        break;
+      if (seen == empty_key || value == ABSENT)
+        return std::nullopt;
+      return value;
+    }
+    // Loaded only now: a slot reads MOVED only after next was linked, and
+    // migration may have started after the scan did.
+    table = table->next.load(std::memory_order_acquire);
+  }
+  return std::nullopt;
+}
@@ -0,0 +1,182 @@
+#pragma once
+#include "open_addressing_hash_table.h"
+
+// Set of keys on the OpenAddressingHashTable engine. Slots are
+// Entry<K, NoValue>, which holds the key alone: occupancy lives only in the
+// control bytes, so a slot is sizeof(K) instead of a key, a padded dummy
+// value and a state. Probing, growth, tombstones and rehashing are the
+// table's own.
+template <typename K, typename HashFunction = std::hash<K>,
+          typename ProbingPolicy = LinearHashing<K>> //
+class OpenAddressingHashSet {
+public:
+  using table_type =
+      OpenAddressingHashTable<K, NoValue, HashFunction, ProbingPolicy>;
+
+  // Usings for STD cointainers
+  using key_type = K;
+  using value_type = K;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = const K &;
+  using const_reference = const K &;
+  using pointer = const K *;
+  using const_pointer = const K *;
+
+  // Keys are read-only: changing one in place would lose it.
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = K;
+    using pointer = const K *;
+    using reference = const K &;
+
+    iterator() = default;
+    explicit iterator(typename table_type::iterator it) : it(it) {}
+
+    iterator operator++() {
+      ++it;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator temp = *this;
+      ++it;
+      return temp;
+    }
+
+    bool operator==(const iterator &other) const { return it == other.it; }
+    bool operator!=(const iterator &other) const { return it != other.it; }
+
+    reference operator*() const { return it->key; }
+    pointer operator->() const { return &it->key; }
+
+  private:
+    typename table_type::iterator it;
+    friend class OpenAddressingHashSet;
+  };
+
+  OpenAddressingHashSet() = default;
+  // Sized so that size_hint keys fit without growing.
+  explicit OpenAddressingHashSet(size_type size_hint) : table(size_hint) {}
+  OpenAddressingHashSet(std::initializer_list<K> init) {
+    table.reserve(init.size());
+    for (const K &key : init)
+      insert(key);
+  }
+  template <typename InputIt, typename = typename std::iterator_traits<
+                                  InputIt>::iterator_category>
+  OpenAddressingHashSet(InputIt first, InputIt last) {
+    for (; first != last; ++first)
+      insert(*first);
+  }
+
+  iterator begin() noexcept { return iterator(table.begin()); }
+  iterator end() noexcept { return iterator(table.end()); }
+  // The table only has mutable iterators; these hand out const keys anyway.
+  iterator begin() const noexcept {
+    return const_cast<OpenAddressingHashSet *>(this)->begin();
+  }
+  iterator end() const noexcept {
+    return const_cast<OpenAddressingHashSet *>(this)->end();
+  }
+
+  std::pair<iterator, bool> insert(const key_type &key) {
+    auto result = table.try_emplace(key);
+    return {iterator(result.first), result.second};
+  }
+  std::pair<iterator, bool> insert(key_type &&key) {
+    auto result = table.try_emplace(std::move(key));
+    return {iterator(result.first), result.second};
+  }
+  size_type erase(const key_type &key) { return table.erase(key); }
+  void erase(iterator pos) { table.erase(pos.it); }
+  iterator find(const key_type &key) { return iterator(table.find(key)); }
+  bool contains(const key_type &key) const { return table.contains(key); }
+  size_type count(const key_type &key) const { return contains(key); }
+  void contains_batch(const key_type *keys, size_type count, bool *out) const {
+    table.contains_batch(keys, count, out);
+  }
+
+  // Adds every key of other. Moving from a larger set takes over its slots
+  // and inserts this set's keys there instead.
+  void merge(const OpenAddressingHashSet &other);
+  void merge(OpenAddressingHashSet &&other);
+  // Keeps only the keys also in other, probing the larger set with the keys
+  // of the smaller one.
+  void intersect(const OpenAddressingHashSet &other);
+
+  bool operator==(const OpenAddressingHashSet &other) const;
+  bool operator!=(const OpenAddressingHashSet &other) const {
+    return !(*this == other);
+  }
+
+  void rehash(size_type new_capacity) { table.rehash(new_capacity); }
+  void reserve(size_type count) { table.reserve(count); }
+  void shrink_to_fit() { table.shrink_to_fit(); }
+
+  size_type size() const noexcept { return table.size(); }
+  bool empty() const noexcept { return table.size() == 0; }
+  size_type bucket_count() const noexcept { return table.bucket_count(); }
+  float load_factor() const noexcept { return table.load_factor(); }
+  float max_load_factor() const noexcept { return table.max_load_factor(); }
+  void max_load_factor(float factor) { table.max_load_factor(factor); }
+
+  void clear() noexcept { table.clear(); }
+  void swap(OpenAddressingHashSet &other) { table.swap(other.table); }
+
+private:
+  table_type table;
+};
+
+template <typename K, typename HashFunction, typename ProbingPolicy>
+void OpenAddressingHashSet<K, HashFunction, ProbingPolicy>::merge(
+    const OpenAddressingHashSet &other) {
+  if (this == &other)
+    return;
+  table.reserve(size() + other.size());
+  for (const K &key : other)
+    insert(key);
+}
+
+template <typename K, typename HashFunction, typename ProbingPolicy>
+void OpenAddressingHashSet<K, HashFunction, ProbingPolicy>::merge(
+    OpenAddressingHashSet &&other) {
+  if (this == &other)
+    return;
+  if (other.size() > size())
+    swap(other);
+  table.reserve(size() + other.size());
+  for (auto it = other.table.begin(); it != other.table.end(); ++it)
+    table.try_emplace(std::move(it->key));
+  other.clear();
+}
+
+template <typename K, typename HashFunction, typename ProbingPolicy>
+void OpenAddressingHashSet<K, HashFunction, ProbingPolicy>::intersect(
+    const OpenAddressingHashSet &other) {
+  if (this == &other)
+    return;
+  if (size() <= other.size()) {
+    for (auto it = table.begin(); it != table.end(); ++it)
+      if (!other.contains(it->key))
+        table.erase(it);
+    return;
+  }
+  OpenAddressingHashSet result(other.size());
+  for (const K &key : other)
+    if (contains(key))
+      result.insert(key);
+  swap(result);
+}
+
+template <typename K, typename HashFunction, typename ProbingPolicy>
+bool OpenAddressingHashSet<K, HashFunction, ProbingPolicy>::operator==(
+    const OpenAddressingHashSet &other) const {
+  if (size() != other.size())
+    return false;
+  for (const K &key : *this)
+    if (!other.contains(key))
+      return false;
+  return true;
+}
@@ -1,14 +1,19 @@
 #pragma once
-<<<<<<< HEAD
+#include "control_bytes.h"
 #include "hash_functions.h"
+#include "hash_table_telemetry.h"
+#include "parallel_utils.h"
 #include <algorithm>
-#include <cstddef>
-=======
-#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <functional>
->>>>>>> develop
+#include <initializer_list>
+#include <iterator>
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 enum class EntryState { EMPTY, OCCUPIED, DELETED };
@@ -16,6 +21,9 @@ enum class EntryState { EMPTY, OCCUPIED, DELETED };
 constexpr float LOAD_FACTOR = 0.7f;
 constexpr float DELETE_FACTOR = 0.3f;
 
+// state is kept by the engines that scan their entries (RobinHoodHashTable,
+// CuckooHashTable). OpenAddressingHashTable and SmallHashTable never write it:
+// control bytes alone say which of their slots are full.
 template <typename K, typename V> //
 struct Entry {
   K key;
@@ -23,75 +31,347 @@ struct Entry {
   EntryState state = EntryState::EMPTY;
 };
 
-template <typename K> struct LinearHashing {
+// Value type of OpenAddressingHashSet. Its entries hold nothing but the key;
+// whether a slot is full is read from the table's control bytes instead.
+struct NoValue {
+  bool operator==(NoValue) const { return true; }
+  bool operator!=(NoValue) const { return false; }
+};
+
+template <typename K> //
+struct Entry<K, NoValue> {
+  K key;
+  inline static NoValue value;
+};
+
+// snapshot_id identifies a policy (or hash function) in saved snapshots;
+// types without one count as custom and cannot be checked on load.
+template <typename T, typename = void>
+struct snapshot_id_of : std::integral_constant<uint32_t, 0> {};
+template <typename T>
+struct snapshot_id_of<T, std::void_t<decltype(T::snapshot_id)>>
+    : std::integral_constant<uint32_t, T::snapshot_id> {};
+
+// Index mixes run on the hash before a probing policy masks it down to a slot
+// index, so that only the low bits matter. IdentityMix trusts the hash
+// function; the others repair hashes whose low bits are weak, like
+// Hash<int> on strided keys (key * odd constant keeps every factor of two of
+// the stride in the low bits).
+
+struct IdentityMix {
+  size_t operator()(size_t hash) const { return hash; }
+};
+
+// Fibonacci hashing: multiply by 2^64 / phi and use the well-mixed middle of
+// the product as the low bits. One multiply and one rotate.
+struct FibonacciMix {
+  static constexpr uint32_t snapshot_id = 1;
+  size_t operator()(size_t hash) const {
+    uint64_t x = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>((x >> 32) | (x << 32));
+  }
+};
+
+// The MurmurHash3 fmix64 finalizer: every input bit affects every output bit
+// with probability close to 1/2, at the cost of two multiplies.
+struct FinalizerMix {
+  static constexpr uint32_t snapshot_id = 2;
+  size_t operator()(size_t hash) const {
+    uint64_t x = hash;
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x);
+  }
+};
+
+// A policy's snapshot_id is its own id with the mix's id in the second byte,
+// or 0 if the mix is custom.
+template <typename Mix>
+constexpr uint32_t mixed_snapshot_id(uint32_t policy_id) {
+  if (std::is_same_v<Mix, IdentityMix>)
+    return policy_id;
+  if (snapshot_id_of<Mix>::value == 0)
+    return 0;
+  return policy_id | snapshot_id_of<Mix>::value << 8;
+}
+
+// The only policy that also works on capacities that are not a power of two
+// (see GrowthPolicy below); those reduce the hash with a modulo instead.
+template <typename K, typename Mix = IdentityMix> struct LinearHashing {
+  static constexpr uint32_t snapshot_id = mixed_snapshot_id<Mix>(1);
   size_t operator()(size_t hash, size_t i, size_t table_size) const {
-    return (hash + i) & (table_size - 1);
+    if ((table_size & (table_size - 1)) == 0)
+      return (mix(hash) + i) & (table_size - 1);
+    size_t index = mix(hash) % table_size + i; // i < table_size
+    return index >= table_size ? index - table_size : index;
   }
+  Mix mix;
 };
 
-template <typename K> struct QuadraticHashing {
+template <typename K, typename Mix = IdentityMix> struct QuadraticHashing {
+  static constexpr uint32_t snapshot_id = mixed_snapshot_id<Mix>(2);
   size_t operator()(size_t hash, size_t i, size_t table_size) const {
     constexpr double c1 = 0.5, c2 = 0.5;
-    return (hash + static_cast<size_t>(c1 * i + c2 * i * i)) & (table_size - 1);
+    return (mix(hash) + static_cast<size_t>(c1 * i + c2 * i * i)) &
+           (table_size - 1);
   }
+  Mix mix;
 };
 
-template <typename K> struct DoubleHashing {
-  size_t operator()(size_t hash1, size_t i, size_t table_size) const {
+template <typename K, typename Mix = IdentityMix> struct DoubleHashing {
+  static constexpr uint32_t snapshot_id = mixed_snapshot_id<Mix>(3);
+  size_t operator()(size_t hash, size_t i, size_t table_size) const {
+    size_t hash1 = mix(hash);
     size_t hash2 = (hash1 ^ (hash1 >> 20) ^ (hash1 >> 12)) & (table_size - 1);
     hash2 = (hash2 | 1); 
     return (hash1 + i * hash2) & (table_size - 1);
   }
+  Mix mix;
 };
 
-template <typename K, typename V, typename HashFunction = std::hash<K>,
-          typename ProbingPolicy = LinearHashing<K>> //
-class OpenAddressingHashTable {
-public:
-  class iterator {
-  public:
-    using iterator_category = std::forward_iterator_tag;
-    using difference_type = std::ptrdiff_t;
-    using value_type = Entry<K, V>;
-    using pointer = value_type *;
-    using reference = value_type &;
-
-    iterator(pointer ptr, pointer end_ptr) : current(ptr), end(end_ptr) {
-      skip_empty();
-    }
+// Linear probing visits consecutive slots, so its probe sequence can be
+// scanned a whole control-byte Group at a time.
+template <typename ProbingPolicy> struct is_linear_probing : std::false_type {};
+template <typename K, typename Mix>
+struct is_linear_probing<LinearHashing<K, Mix>> : std::true_type {};
+
+// Hash functions declaring is_transparent (like Hash<std::string>) may be
+// called with any type comparable to the key, e.g. std::string_view.
+template <typename HashFunction, typename = void>
+struct is_transparent : std::false_type {};
+template <typename HashFunction>
+struct is_transparent<HashFunction,
+                      std::void_t<typename HashFunction::is_transparent>>
+    : std::true_type {};
+
+// Wrapping a hash function in StoreHash keeps each entry's full hash in the
+// table: rehash() reuses it instead of hashing the key again, and probing
+// compares keys only after the stored hash matches. Worth it for keys that are
+// expensive to hash or compare, such as long strings.
+template <typename HashFunction> struct StoreHash : HashFunction {
+  static constexpr bool store_hash = true;
+};
 
-    iterator operator++() {
-      ++current;
-      skip_empty();
-      return *this;
-    };
+template <typename HashFunction, typename = void>
+struct stores_hash : std::false_type {};
+template <typename HashFunction>
+struct stores_hash<HashFunction, std::enable_if_t<HashFunction::store_hash>>
+    : std::true_type {};
+
+// Growth policies pick the capacities a table moves through. next() is the
+// capacity to grow to from capacity, round_up() the smallest capacity the
+// policy allows that is at least min_capacity. Policies that leave the powers
+// of two need LinearHashing, whose probe sequence still covers every slot.
+//
+// DoublingGrowth (the default) keeps the cheap mask reduction and amortizes
+// rehashing best, but a table just past a boundary is barely over half full.
+// OneAndHalfGrowth wastes less memory at a modulo per lookup and about twice
+// the rehashing. FixedStepGrowth<Step> grows by Step slots at a time: tight
+// memory for tables of a known rough size, quadratic rehashing beyond it.
+struct DoublingGrowth {
+  static constexpr bool power_of_two = true;
+  static size_t next(size_t capacity) { return capacity * 2; }
+  static size_t round_up(size_t min_capacity) {
+    size_t capacity = 4;
+    while (capacity < min_capacity)
+      capacity *= 2;
+    return capacity;
+  }
+};
 
-    iterator operator++(int) {
-      pointer temp = *this;
-      ++current;
-      skip_empty();
-      return temp;
-    };
+struct OneAndHalfGrowth {
+  static constexpr bool power_of_two = false;
+  static size_t next(size_t capacity) { return capacity + capacity / 2; }
+  static size_t round_up(size_t min_capacity) {
+    return std::max<size_t>(4, min_capacity);
+  }
+};
 
-    bool operator==(const iterator &other) const {
-      return current == other.current;
-    }
-    bool operator!=(const iterator &other) const { return !(*this == other); }
+template <size_t Step> struct FixedStepGrowth {
+  static_assert(Step > 0, "FixedStepGrowth needs a positive step");
+  static constexpr bool power_of_two = false;
+  static size_t next(size_t capacity) { return capacity + Step; }
+  static size_t round_up(size_t min_capacity) {
+    return std::max<size_t>(4, (min_capacity + Step - 1) / Step * Step);
+  }
+};
 
-    reference operator*() const { return *current; }
-    pointer operator->() const { return current; };
+// Next slot after a Group scan starting at pos, for any capacity.
+inline size_t wrap_slot(size_t pos, size_t capacity) {
+  return pos >= capacity ? pos - capacity : pos;
+}
 
-  private:
-    pointer current;
-    pointer end;
+// Probe loop behind every lookup, over raw slot arrays so that tables which
+// do not own their storage can share it. Returns the slot holding key, or
+// capacity if it is absent; hashes is only read when StoredHashes is set.
+template <bool StoredHashes, typename ProbingPolicy, typename EntryType,
+          typename Q>
+size_t find_slot(const ProbingPolicy &probe, const ctrl_t *ctrl,
+                 const EntryType *data, const size_t *hashes, size_t capacity,
+                 const Q &key, size_t hash) {
+  const ctrl_t tag = ctrl_tag(hash);
+  auto matches = [&](size_t index) {
+    if constexpr (StoredHashes)
+      if (hashes[index] != hash)
+        return false;
+    return data[index].key == key;
+  };
 
-    void skip_empty() {
-      while (current != end && current->state != EntryState::OCCUPIED) {
-        ++current;
+  if constexpr (is_linear_probing<ProbingPolicy>::value) {
+    if (capacity >= Group::WIDTH) {
+      size_t pos = probe(hash, 0, capacity);
+      for (size_t scanned = 0; scanned < capacity; scanned += Group::WIDTH) {
+        Group group(ctrl + pos);
+        for (uint32_t offset : group.match(tag)) {
+          size_t index = wrap_slot(pos + offset, capacity);
+          if (matches(index))
+            return index;
+        }
+        if (group.match_empty())
+          return capacity;
+        pos = wrap_slot(pos + Group::WIDTH, capacity);
       }
+      return capacity;
     }
+  }
+
+  for (size_t i = 0; i < capacity; ++i) {
+    size_t index = probe(hash, i, capacity);
+    if (ctrl[index] == CTRL_EMPTY)
+      return capacity;
+    if (ctrl[index] == tag && matches(index))
+      return index;
+  }
+  return capacity;
+}
+
+// Walks an Entry array, stopping only on OCCUPIED slots.
+template <typename K, typename V> //
+class EntryIterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = Entry<K, V>;
+  using pointer = value_type *;
+  using reference = value_type &;
+
+  EntryIterator() : current(nullptr), end(nullptr) {}
+  EntryIterator(pointer ptr, pointer end_ptr) : current(ptr), end(end_ptr) {
+    skip_empty();
+  }
+
+  EntryIterator operator++() {
+    ++current;
+    skip_empty();
+    return *this;
+  };
+
+  EntryIterator operator++(int) {
+    EntryIterator temp = *this;
+    ++current;
+    skip_empty();
+    return temp;
   };
 
+  bool operator==(const EntryIterator &other) const {
+    return current == other.current;
+  }
+  bool operator!=(const EntryIterator &other) const {
+    return !(*this == other);
+  }
+
+  reference operator*() const { return *current; }
+  pointer operator->() const { return current; };
+
+private:
+  pointer current;
+  pointer end;
+
+  void skip_empty() {
+    while (current != end && current->state != EntryState::OCCUPIED) {
+      ++current;
+    }
+  }
+};
+
+// EntryIterator for tables that keep occupancy in control bytes, walking them
+// alongside the slots.
+template <typename K, typename V> //
+class ControlledEntryIterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = Entry<K, V>;
+  using pointer = value_type *;
+  using reference = value_type &;
+
+  ControlledEntryIterator() : current(nullptr), end(nullptr), ctrl(nullptr) {}
+  ControlledEntryIterator(pointer ptr, pointer end_ptr, const ctrl_t *ctrl)
+      : current(ptr), end(end_ptr), ctrl(ctrl) {
+    skip_empty();
+  }
+
+  ControlledEntryIterator operator++() {
+    ++current;
+    ++ctrl;
+    skip_empty();
+    return *this;
+  }
+  ControlledEntryIterator operator++(int) {
+    ControlledEntryIterator temp = *this;
+    ++*this;
+    return temp;
+  }
+
+  bool operator==(const ControlledEntryIterator &other) const {
+    return current == other.current;
+  }
+  bool operator!=(const ControlledEntryIterator &other) const {
+    return !(*this == other);
+  }
+
+  reference operator*() const { return *current; }
+  pointer operator->() const { return current; }
+
+private:
+  pointer current;
+  pointer end;
+  const ctrl_t *ctrl;
+
+  void skip_empty() {
+    while (current != end && !is_full(*ctrl)) {
+      ++current;
+      ++ctrl;
+    }
+  }
+};
+
+template <typename K, typename V, typename HashFunction,
+          typename ProbingPolicy>
+class MappedOpenAddressingHashTable;
+template <typename K, typename V, typename HashFunction>
+class FrozenHashTable;
+
+// Allocator hands out the Entry array; the control bytes and stored hashes
+// use the same allocator rebound to their element types. GrowthPolicy picks
+// the capacities (see DoublingGrowth).
+template <typename K, typename V, typename HashFunction = std::hash<K>,
+          typename ProbingPolicy = LinearHashing<K>,
+          typename Allocator = std::allocator<Entry<K, V>>,
+          typename GrowthPolicy = DoublingGrowth> //
+class OpenAddressingHashTable {
+  static_assert(GrowthPolicy::power_of_two ||
+                    is_linear_probing<ProbingPolicy>::value,
+                "capacities that are not powers of two need LinearHashing");
+
+  template <typename T>
+  using rebind_alloc =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+public:
   // Usings for STD cointainers
   using key_type = K;
   using mapped_type = V;
@@ -102,35 +382,74 @@ public:
   using const_reference = const value_type &;
   using pointer = value_type *;
   using const_pointer = const value_type *;
-
-  using iterator = iterator;
-
-  OpenAddressingHashTable() : num_elements(0), data(4), num_deleted(0) {}
+  using allocator_type = Allocator;
+
+  using iterator = ControlledEntryIterator<K, V>;
+
+  OpenAddressingHashTable() : OpenAddressingHashTable(Allocator()) {}
+  explicit OpenAddressingHashTable(const Allocator &alloc)
+      : data(4, alloc), ctrl(control_size(4), CTRL_EMPTY, alloc),
+        hashes(STORE_HASH ? 4 : 0, 0, alloc), num_elements(0),
+        num_deleted(0) {}
+  // Sized so that size_hint elements fit without growing.
+  explicit OpenAddressingHashTable(size_type size_hint,
+                                   const Allocator &alloc = Allocator())
+      : OpenAddressingHashTable(alloc) {
+    reserve(size_hint);
+  }
+  // From a range of key/value pairs; duplicate keys keep their first value.
+  template <typename InputIt, typename = typename std::iterator_traits<
+                                  InputIt>::iterator_category>
+  OpenAddressingHashTable(InputIt first, InputIt last, size_type size_hint = 0,
+                          const Allocator &alloc = Allocator())
+      : OpenAddressingHashTable(alloc) {
+    reserve(size_hint);
+    bulk_insert(first, last);
+  }
   OpenAddressingHashTable(std::initializer_list<std::pair<const K, V>> init)
-      : num_elements(0), num_deleted(0), data(4) {
-    for (auto &p : init)
-      insert(p.first, p.second);
+      : OpenAddressingHashTable() {
+    bulk_insert(init.begin(), init.end());
   }
   OpenAddressingHashTable(OpenAddressingHashTable &&other)
-      : num_elements(other.num_elements), data(std::move(other.data)),
-        num_deleted(other.num_deleted), hasher(std::move(other.hasher)) {
+      : data(std::move(other.data)), ctrl(std::move(other.ctrl)),
+        hashes(std::move(other.hashes)), hasher(std::move(other.hasher)),
+        num_elements(other.num_elements), num_deleted(other.num_deleted),
+        max_load(other.max_load), max_tombstones(other.max_tombstones),
+        telemetry(other.telemetry) {
     other.num_deleted = 0;
     other.num_elements = 0;
   }
   OpenAddressingHashTable(const OpenAddressingHashTable &other)
-      : num_elements(other.num_elements), data(other.data),
-        num_deleted(other.num_deleted), hasher(other.hasher) {}
-
-  iterator begin() noexcept {
-    return iterator(data.data(), data.data() + data.size());
-  };
-  iterator end() noexcept {
-    return iterator(data.data() + data.size(), data.data() + data.size());
-  };
-
-  void insert(key_type key, mapped_type value);
-  size_type erase(key_type key);
-  iterator find(key_type key);
+      : data(other.data), ctrl(other.ctrl), hashes(other.hashes),
+        hasher(other.hasher),
+        num_elements(other.num_elements), num_deleted(other.num_deleted),
+        max_load(other.max_load), max_tombstones(other.max_tombstones) {}
+
+  iterator begin() noexcept { return iterator_at(0); };
+  iterator end() noexcept { return iterator_at(data.size()); };
+
+  // Insertions never overwrite: when the key is already present the
+  // returned iterator points at the existing entry and the flag is false.
+  std::pair<iterator, bool> insert(key_type key, mapped_type value);
+  template <typename KeyArg, typename... Args>
+  std::pair<iterator, bool> emplace(KeyArg &&key, Args &&...args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type &key, Args &&...args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type &&key, Args &&...args);
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&value);
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&value);
+  // Inserts every key/value pair of the range. Forward ranges are measured
+  // first and the table grows at most once.
+  template <typename InputIt> void bulk_insert(InputIt first, InputIt last);
+  size_type erase(const key_type &key);
+  // Leaves a tombstone but never rehashes, so other iterators stay valid.
+  // Returns nothing: finding the next entry could mean scanning a long run of
+  // free slots.
+  void erase(iterator pos);
+  iterator find(const key_type &key);
 
   void operator=(const OpenAddressingHashTable &other);
   void operator=(OpenAddressingHashTable &&other);
@@ -138,20 +457,145 @@ public:
   bool operator==(OpenAddressingHashTable &other);
   bool operator!=(OpenAddressingHashTable &other);
 
-  mapped_type &operator[](key_type key);
-  mapped_type &at(key_type key);
+  mapped_type &operator[](const key_type &key);
+  mapped_type &at(const key_type &key);
 
   void rehash(size_type new_capacity);
-
-  std::vector<Entry<K, V>> get_container() const { return data; }
+  // rehash() spread over threads (0: one per hardware thread). Same contents
+  // as rehash(), though entries may land in different slots. Falls back to
+  // the serial pass when the table is too small to be worth splitting.
+  void parallel_rehash(size_type new_capacity, unsigned threads = 0);
+  // bulk_insert() of a random-access range spread over threads (0: one per
+  // hardware thread). Keys are partitioned by the thread that owns their
+  // home slot, and every thread fills only its own part of the slot array.
+  // Duplicate keys keep their first value. Falls back to bulk_insert when
+  // the table is too small to be worth splitting.
+  template <typename RandomIt>
+  void parallel_build(RandomIt first, RandomIt last, unsigned threads = 0);
+
+  // A run of slot indices [begin, end).
+  struct SlotRange {
+    size_type begin;
+    size_type end;
+  };
+  // Splits the slots into at most n ranges of about equal size, for handing
+  // out to threads. Boundaries fall on control-byte group edges.
+  std::vector<SlotRange> slot_ranges(size_type n) const;
+  // Calls f(entry) for every entry in range. Control bytes are read a group
+  // at a time, so a run of free slots costs one compare per Group::WIDTH.
+  template <typename F> void for_each(SlotRange range, F f);
+  template <typename F> void for_each(SlotRange range, F f) const;
+  // for_each over one slot range per thread (0: one per hardware thread;
+  // small tables use fewer). f is called concurrently, each call with a
+  // different entry.
+  template <typename F> void parallel_for_each(F f, unsigned threads = 0);
+  // Folds map(entry) into init with combine. Every thread folds its own
+  // range starting from init, then the partial results are folded in range
+  // order, so combine must be associative and init its identity.
+  template <typename T, typename Map, typename Combine>
+  T parallel_reduce(T init, Map map, Combine combine,
+                    unsigned threads = 0) const;
+  // Grows, if needed, so that count elements fit without another rehash.
+  void reserve(size_type count);
+  // Rehashes into the smallest capacity that holds size() elements, which
+  // also drops every tombstone. clear() keeps the capacity for reuse; call
+  // this afterwards to give the memory back.
+  void shrink_to_fit();
+
+  std::vector<Entry<K, V>> get_container() const {
+    return std::vector<Entry<K, V>>(data.begin(), data.end());
+  }
+  allocator_type get_allocator() const { return data.get_allocator(); }
 
   size_type size() const noexcept { return num_elements; }
+  size_type bucket_count() const noexcept { return data.size(); }
+  float load_factor() const noexcept {
+    return data.empty() ? 0.0f : static_cast<float>(num_elements) / data.size();
+  }
+  // Load above which an insert grows the table; LOAD_FACTOR by default.
+  // Higher values trade longer probes for less memory. Must be in (0, 1);
+  // lowering it below the current load rehashes right away.
+  float max_load_factor() const noexcept { return max_load; }
+  void max_load_factor(float factor);
+  // Share of tombstones at which an erase rehashes them away (shrinking the
+  // table if it has drained); DELETE_FACTOR by default. Must be in (0, 1).
+  float max_tombstone_factor() const noexcept { return max_tombstones; }
+  void max_tombstone_factor(float factor);
+
+  // Starts (or, with nullptr, stops) recording into telemetry, which must
+  // outlive the table or be detached first. Copies of the table start
+  // without telemetry; moves take it along.
+  void set_telemetry(HashTableTelemetry *telemetry) noexcept {
+    this->telemetry = telemetry;
+  }
+  HashTableTelemetry *get_telemetry() const noexcept { return telemetry; }
+  // What the attached telemetry recorded, plus this table's current load and
+  // tombstones. Without telemetry only the table fields are filled in.
+  TelemetrySnapshot telemetry_snapshot() const;
   bool empty() const noexcept { return num_elements == 0 ? 1 : 0; }
 
   void clear() noexcept;
   bool contains(const key_type &key) const;
 
-  void swap(OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy> &other);
+  // Looks up keys[0..count) and writes one result per key to out. All keys
+  // of a block are hashed and their home slots prefetched before any probe
+  // runs, so the cache misses of an out-of-cache table overlap.
+  void find_batch(const key_type *keys, size_type count, iterator *out);
+  void contains_batch(const key_type *keys, size_type count, bool *out) const;
+
+  void swap(OpenAddressingHashTable &other);
+
+  // Writes the slot arrays to path so that map() can serve them without
+  // rebuilding. Needs trivially copyable K and V; throws std::runtime_error
+  // when the file cannot be written.
+  void save(const std::string &path) const;
+  // Read-only table backed by an mmap of a file written by save(). Throws
+  // std::runtime_error if the file is unreadable or was saved by a table with
+  // a different layout, probing policy or hash function.
+  static MappedOpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>
+  map(const std::string &path);
+  // Immutable copy on a minimal perfect hash: every slot full, one probe per
+  // lookup (see FrozenHashTable).
+  FrozenHashTable<K, V, HashFunction> freeze() const;
+
+  // Heterogeneous lookup, only offered when HashFunction is transparent. The
+  // key is converted to key_type only when a new entry has to be stored.
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  iterator find(const Q &key) {
+    size_type index = find_index(key, hasher(key));
+    if (index == data.size())
+      return end();
+    return iterator_at(index);
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  bool contains(const Q &key) const {
+    return find_index(key, hasher(key)) != data.size();
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  mapped_type &at(const Q &key) {
+    size_type index = find_index(key, hasher(key));
+    if (index == data.size())
+      throw std::out_of_range("function at(): key was not found");
+    return data[index].value;
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  size_type erase(const Q &key) {
+    return erase_hashed(key, hasher(key));
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  mapped_type &operator[](const Q &key) {
+    return try_emplace_hashed(key, hasher(key)).first->value;
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  std::pair<iterator, bool> insert(const Q &key, mapped_type value) {
+    return try_emplace_hashed(key, hasher(key), std::move(value));
+  }
 
 #ifdef HASH_TABLE_STATISTIC
   size_t getDeletedElements() const { return num_deleted; }
@@ -159,253 +603,984 @@ public:
   size_t getRehashCollisions() const { return rehashCollisions; }
   size_t getRehashCount() const { return rehashCount; }
 #endif // HASH_TABLE_STATISTIC
-  std::vector<Entry<K, V>> data;
+  std::vector<Entry<K, V>, Allocator> data;
+  // data.size() control bytes plus a copy of the first Group::WIDTH - 1, so a
+  // Group load starting near the end of the table wraps without a branch.
+  std::vector<ctrl_t, rebind_alloc<ctrl_t>> ctrl;
+  // Full hash of every slot when HashFunction is wrapped in StoreHash,
+  // otherwise empty.
+  std::vector<size_t, rebind_alloc<size_t>> hashes;
   HashFunction hasher;
   ProbingPolicy probe;
   size_t num_elements;
   size_t num_deleted;
+  float max_load = LOAD_FACTOR;
+  float max_tombstones = DELETE_FACTOR;
+  HashTableTelemetry *telemetry = nullptr;
 #ifdef HASH_TABLE_STATISTIC
 
   size_t insertCollisions = 0;
   size_t rehashCollisions = 0;
   size_t rehashCount = 0;
 #endif // HASH_TABLE_STATISTIC
+
+private:
+  static constexpr bool STORE_HASH = stores_hash<HashFunction>::value;
+
+  static size_type control_size(size_type capacity) {
+    return capacity + Group::WIDTH - 1;
+  }
+  void set_ctrl(size_type index, ctrl_t value) {
+    ctrl[index] = value;
+    if (index < Group::WIDTH - 1)
+      ctrl[data.size() + index] = value;
+  }
+  void set_occupied(size_type index, size_t hash) {
+    set_ctrl(index, ctrl_tag(hash));
+    if constexpr (STORE_HASH)
+      hashes[index] = hash;
+  }
+  bool needs_grow() const {
+    return data.empty() ||
+           static_cast<float>(num_elements) / data.size() > max_load;
+  }
+  void grow() {
+    size_type next = data.empty() ? 4 : GrowthPolicy::next(data.size());
+    rehash(std::max(next, capacity_for(num_elements + 1)));
+  }
+  // New slots per thread below which parallel_rehash and parallel_build stay
+  // serial.
+  static constexpr size_type PARALLEL_REHASH_MIN_SLOTS = 1 << 14;
+  // Slots per thread below which the parallel scans use fewer threads.
+  static constexpr size_type PARALLEL_SCAN_MIN_SLOTS = 1 << 16;
+  unsigned scan_threads(unsigned threads) const {
+    if (threads == 0)
+      threads = default_thread_count();
+    size_type most = std::max<size_type>(1, data.size() /
+                                                PARALLEL_SCAN_MIN_SLOTS);
+    return static_cast<unsigned>(std::min<size_type>(threads, most));
+  }
+  // Passes the index of every full slot in range to f, lowest first. With
+  // stop, gives up at the next group once *stop is set.
+  template <typename F>
+  void for_each_full(SlotRange range, F f,
+                     const std::atomic<bool> *stop = nullptr) const;
+  // Counting sort of items [0, count) by the thread that owns their home
+  // slot, with a table of capacity slots split evenly over threads. Items
+  // where skip(i) holds are left out; hash_of(i) is called once for each of
+  // the others, and its result kept in item_hashes[i]. The items of thread t
+  // end up in order[bucket_begin[t]] .. order[bucket_begin[t + 1] - 1], in
+  // their original order.
+  template <typename Skip, typename HashOf>
+  void partition_by_home(unsigned threads, size_type count,
+                         size_type capacity, Skip skip, HashOf hash_of,
+                         size_t *item_hashes, std::vector<size_type> &order,
+                         std::vector<size_type> &bucket_begin) const;
+  // Smallest capacity GrowthPolicy allows that holds count elements under
+  // max_load.
+  size_type capacity_for(size_type count) const {
+    size_type capacity = GrowthPolicy::round_up(
+        static_cast<size_type>(static_cast<float>(count) / max_load));
+    while (static_cast<float>(count) / capacity > max_load)
+      capacity = GrowthPolicy::round_up(capacity + 1);
+    return capacity;
+  }
+
+  // Slot holding key, or data.size() if it is absent.
+  template <typename Q> size_type find_index(const Q &key, size_t hash) const;
+  // First free slot on the probe sequence; probes is the number of full slots
+  // skipped on the way.
+  size_type find_insert_index(size_t hash, size_t &probes) const;
+  // Slots a lookup of hash examined to end at index (a miss ends at the
+  // first empty slot). Only run for sampled telemetry.
+  size_type probe_length(size_t hash, size_type index) const;
+
+  // Keys hashed and prefetched ahead of their probes by the batch lookups
+  // and bulk_insert.
+  static constexpr size_type BATCH_SIZE = 32;
+  void prefetch_slot(size_t hash) const {
+    size_t home = probe(hash, 0, data.size());
+    __builtin_prefetch(ctrl.data() + home);
+    __builtin_prefetch(data.data() + home);
+    if constexpr (STORE_HASH)
+      __builtin_prefetch(hashes.data() + home);
+  }
+  template <typename Resolve>
+  void find_batch_indices(const key_type *keys, size_type count,
+                          Resolve resolve) const;
+
+  iterator iterator_at(size_type index) {
+    return iterator(data.data() + index, data.data() + data.size(),
+                    ctrl.data() + index);
+  }
+
+  // Looks key up and, if it is missing, stores key_type(key) together with
+  // mapped_type(args...). Nothing is constructed when the key exists.
+  template <typename KeyArg, typename... Args>
+  std::pair<iterator, bool> try_emplace_hashed(KeyArg &&key, size_t hash,
+                                               Args &&...args);
+  template <typename Q> size_type erase_hashed(const Q &key, size_t hash);
 };
 
-template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
-void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::insert(
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+std::pair<typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                           Allocator, GrowthPolicy>::iterator,
+          bool>
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                        GrowthPolicy>::insert(
     key_type key, mapped_type value) {
-  if ((float)num_elements / data.size() > LOAD_FACTOR) {
-    rehash(data.size() * 2);
-  }
+  size_t hash = hasher(key);
+  return try_emplace_hashed(std::move(key), hash, std::move(value));
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename KeyArg, typename... Args>
+std::pair<typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                           Allocator, GrowthPolicy>::iterator,
+          bool>
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                        GrowthPolicy>::emplace(
+    KeyArg &&key, Args &&...args) {
+  key_type new_key(std::forward<KeyArg>(key));
+  size_t hash = hasher(new_key);
+  return try_emplace_hashed(std::move(new_key), hash,
+                            std::forward<Args>(args)...);
+}
 
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename... Args>
+std::pair<typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                           Allocator, GrowthPolicy>::iterator,
+          bool>
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                        Allocator, GrowthPolicy>::try_emplace(
+    const key_type &key, Args &&...args) {
+  return try_emplace_hashed(key, hasher(key), std::forward<Args>(args)...);
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename... Args>
+std::pair<typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                           Allocator, GrowthPolicy>::iterator,
+          bool>
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                        Allocator, GrowthPolicy>::try_emplace(
+    key_type &&key, Args &&...args) {
   size_t hash = hasher(key);
-  size_t i = 0;
+  return try_emplace_hashed(std::move(key), hash, std::forward<Args>(args)...);
+}
 
-  size_t index = probe(hash, i, data.size());
-  while (data[index].state == EntryState::OCCUPIED) {
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename M>
+std::pair<typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                           Allocator, GrowthPolicy>::iterator,
+          bool>
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                        Allocator, GrowthPolicy>::insert_or_assign(
+    const key_type &key, M &&value) {
+  auto result = try_emplace_hashed(key, hasher(key), std::forward<M>(value));
+  if (!result.second)
+    result.first->value = std::forward<M>(value);
+  return result;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename M>
+std::pair<typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                           Allocator, GrowthPolicy>::iterator,
+          bool>
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                        Allocator, GrowthPolicy>::insert_or_assign(
+    key_type &&key, M &&value) {
+  size_t hash = hasher(key);
+  auto result =
+      try_emplace_hashed(std::move(key), hash, std::forward<M>(value));
+  if (!result.second)
+    result.first->value = std::forward<M>(value);
+  return result;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename InputIt>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::bulk_insert(
+    InputIt first, InputIt last) {
+  using category = typename std::iterator_traits<InputIt>::iterator_category;
+  if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+    reserve(num_elements + std::distance(first, last));
+
+    // Nothing grows from here on, so blocks can be hashed and prefetched
+    // ahead of their inserts as in find_batch.
+    size_t batch_hashes[BATCH_SIZE];
+    while (first != last) {
+      InputIt block = first;
+      size_type n = 0;
+      for (; n < BATCH_SIZE && first != last; ++n, ++first) {
+        batch_hashes[n] = hasher(first->first);
+        prefetch_slot(batch_hashes[n]);
+      }
+      for (size_type i = 0; i < n; ++i, ++block)
+        try_emplace_hashed(block->first, batch_hashes[i], block->second);
+    }
+  } else {
+    for (; first != last; ++first)
+      try_emplace_hashed(first->first, hasher(first->first), first->second);
+  }
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename KeyArg, typename... Args>
+std::pair<typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                           Allocator, GrowthPolicy>::iterator,
+          bool>
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                        Allocator, GrowthPolicy>::try_emplace_hashed(
+    KeyArg &&key, size_t hash, Args &&...args) {
+  size_t index = find_index(key, hash);
+  if (index != data.size())
+    return {iterator_at(index), false};
+
+  if (needs_grow()) {
+    grow();
+  }
+
+  size_t probes = 0;
+  index = find_insert_index(hash, probes);
 #ifdef HASH_TABLE_STATISTIC
-    insertCollisions++;
+  insertCollisions += probes;
 #endif // HASH_TABLE_STATISTIC
-    index = probe(hash, ++i, data.size());
-  }
+  if (telemetry && telemetry->sample())
+    telemetry->record_insert(probes + 1);
 
-  if (data[index].state == EntryState::DELETED) {
+  if (ctrl[index] == CTRL_DELETED) {
     num_deleted--;
   }
 
-  data[index].value = value;
-  data[index].key = key;
-  data[index].state = EntryState::OCCUPIED;
+  data[index].value = mapped_type(std::forward<Args>(args)...);
+  data[index].key = key_type(std::forward<KeyArg>(key));
+  set_occupied(index, hash);
   num_elements++;
-  return;
+  return {iterator_at(index), true};
 }
 
-/// ================== OPERATORS ================
-template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
-typename OpenAddressingHashTable<K, V, HashFunction,
-                                 ProbingPolicy>::mapped_type &
-OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::operator[](
-    key_type key) {
-  size_t hash = hasher(key);
-  size_t i = 0;
-  size_t index = probe(hash, i, data.size());
+/// ================== PROBING ==================
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename Q>
+typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                 Allocator, GrowthPolicy>::size_type
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                        Allocator, GrowthPolicy>::find_index(
+    const Q &key, size_t hash) const {
+  size_type index = find_slot<STORE_HASH>(
+      probe, ctrl.data(), data.data(), hashes.data(), data.size(), key, hash);
+  if (telemetry && telemetry->sample())
+    telemetry->record_find(probe_length(hash, index), index != data.size());
+  return index;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                 Allocator, GrowthPolicy>::size_type
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                        GrowthPolicy>::probe_length(size_t hash,
+                                                    size_type index) const {
+  const size_t capacity = data.size();
+  for (size_t i = 0; i < capacity; ++i) {
+    size_t slot = probe(hash, i, capacity);
+    if (slot == index || ctrl[slot] == CTRL_EMPTY)
+      return i + 1;
+  }
+  return capacity;
+}
 
-  while (data[index].state != EntryState::EMPTY) {
-    if (data[index].state == EntryState::OCCUPIED && data[index].key == key) {
-      return data[index].value;
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename Resolve>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::
+    find_batch_indices(const key_type *keys, size_type count,
+                       Resolve resolve) const {
+  size_t batch_hashes[BATCH_SIZE];
+
+  for (size_type first = 0; first < count; first += BATCH_SIZE) {
+    size_type n = std::min(BATCH_SIZE, count - first);
+    for (size_type i = 0; i < n; ++i) {
+      batch_hashes[i] = hasher(keys[first + i]);
+      prefetch_slot(batch_hashes[i]);
     }
-    index = probe(hash, ++i, data.size());
+    for (size_type i = 0; i < n; ++i)
+      resolve(first + i, find_index(keys[first + i], batch_hashes[i]));
   }
-  if (static_cast<float>(num_elements) / data.size() > LOAD_FACTOR) {
-    rehash(data.size() * 2);
-    i = 0;
-    index = probe(hash, ++i, data.size());
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                             Allocator, GrowthPolicy>::find_batch(
+    const key_type *keys, size_type count, iterator *out) {
+  find_batch_indices(keys, count, [this, out](size_type i, size_type index) {
+    out[i] = index == data.size() ? end() : iterator_at(index);
+  });
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::
+    contains_batch(const key_type *keys, size_type count, bool *out) const {
+  find_batch_indices(keys, count, [this, out](size_type i, size_type index) {
+    out[i] = index != data.size();
+  });
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                 Allocator, GrowthPolicy>::size_type
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                        Allocator, GrowthPolicy>::find_insert_index(
+    size_t hash, size_t &probes) const {
+  const size_t capacity = data.size();
+
+  if constexpr (is_linear_probing<ProbingPolicy>::value) {
+    if (capacity >= Group::WIDTH) {
+      size_t pos = probe(hash, 0, capacity);
+      for (size_t scanned = 0;; scanned += Group::WIDTH) {
+        BitMask free = Group(ctrl.data() + pos).match_empty_or_deleted();
+        if (free) {
+          probes += scanned + free.lowest();
+          return wrap_slot(pos + free.lowest(), capacity);
+        }
+        pos = wrap_slot(pos + Group::WIDTH, capacity);
+      }
+    }
   }
-  data[index].value = mapped_type{};
-  data[index].key = key;
-  data[index].state = EntryState::OCCUPIED;
-  num_elements++;
-  return data[index].value;
+
+  size_t i = 0;
+  size_t index = probe(hash, i, capacity);
+  while (is_full(ctrl[index])) {
+    index = probe(hash, ++i, capacity);
+  }
+  probes += i;
+  return index;
 }
 
-template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
-void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::operator=(
+/// ================== OPERATORS ================
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                 Allocator, GrowthPolicy>::mapped_type &
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                        GrowthPolicy>::operator[](const key_type &key) {
+  return try_emplace_hashed(key, hasher(key)).first->value;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                             Allocator, GrowthPolicy>::operator=(
     const OpenAddressingHashTable &other) {
   data = other.data;
+  ctrl = other.ctrl;
+  hashes = other.hashes;
   num_deleted = other.num_deleted;
   num_elements = other.num_elements;
+  max_load = other.max_load;
+  max_tombstones = other.max_tombstones;
   hasher = other.hasher;
   probe = other.probe;
 }
 
-template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
-void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::operator=(
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                             Allocator, GrowthPolicy>::operator=(
     OpenAddressingHashTable &&other) {
   data = std::move(other.data);
+  ctrl = std::move(other.ctrl);
+  hashes = std::move(other.hashes);
   hasher = std::move(other.hasher);
   probe = std::move(other.probe);
 
   num_deleted = other.num_deleted;
   num_elements = other.num_elements;
+  max_load = other.max_load;
+  max_tombstones = other.max_tombstones;
+  telemetry = other.telemetry;
 
   other.num_elements = 0;
   other.num_deleted = 0;
 }
 
-template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
-bool OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::operator==(
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+bool OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                             Allocator, GrowthPolicy>::operator==(
     OpenAddressingHashTable &other) {
   if (other.num_elements != num_elements)
     return false;
 
-  for (auto &entry : data) {
-    if (entry.state != EntryState::OCCUPIED)
-      continue;
-
-    iterator it = other.find(entry.key);
-    if (it == other.end() || it->value != entry.value)
-      return false;
+  // With equal sizes, finding every entry of this table in other with the
+  // same value is enough.
+  std::vector<SlotRange> ranges = slot_ranges(scan_threads(0));
+  if (ranges.size() <= 1) {
+    for (size_type index = 0; index < data.size(); ++index) {
+      if (!is_full(ctrl[index]))
+        continue;
+
+      const Entry<K, V> &entry = data[index];
+      iterator it = other.find(entry.key);
+      if (it == other.end() || it->value != entry.value)
+        return false;
+    }
+    return true;
   }
-  return true;
+
+  // Large tables are split over threads. They probe other without
+  // find_index(), whose telemetry sampling is not meant for concurrent
+  // callers, and all stop at the next group once one finds a mismatch.
+  std::atomic<bool> mismatch{false};
+  run_in_parallel(static_cast<unsigned>(ranges.size()), [&](unsigned t) {
+    for_each_full(
+        ranges[t],
+        [&](size_type index) {
+          const Entry<K, V> &entry = data[index];
+          size_type found = find_slot<STORE_HASH>(
+              other.probe, other.ctrl.data(), other.data.data(),
+              other.hashes.data(), other.data.size(), entry.key,
+              other.hasher(entry.key));
+          if (found == other.data.size() ||
+              other.data[found].value != entry.value)
+            mismatch.store(true, std::memory_order_relaxed);
+        },
+        &mismatch);
+  });
+  return !mismatch.load(std::memory_order_relaxed);
 }
 
-template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
-bool OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::operator!=(
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+bool OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                             Allocator, GrowthPolicy>::operator!=(
     OpenAddressingHashTable &other) {
   return !(*this == other);
 }
 
-template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
-typename OpenAddressingHashTable<K, V, HashFunction,
-                                 ProbingPolicy>::mapped_type &
-OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::at(key_type key) {
-  size_t hash = hasher(key);
-  size_t i = 0;
-  size_t index = probe(hash, i, data.size());
-
-  while (data[index].state != EntryState::EMPTY) {
-    if (data[index].state == EntryState::OCCUPIED && data[index].key == key)
-      return data[index].value;
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                 Allocator, GrowthPolicy>::mapped_type &
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                        GrowthPolicy>::at(const key_type &key) {
+  size_t index = find_index(key, hasher(key));
+  if (index == data.size())
+    throw std::out_of_range("function at(): key was not found");
+  return data[index].value;
+}
 
-    ++i;
-    index = probe(hash, i, data.size());
-  }
-  throw std::out_of_range("function at(): key was not found");
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                 Allocator, GrowthPolicy>::size_type
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                        GrowthPolicy>::erase(const key_type &key) {
+  return erase_hashed(key, hasher(key));
 }
-template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
-typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::size_type
-OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::erase(
-    key_type key) {
-  if (static_cast<float>(num_deleted) / data.size() > DELETE_FACTOR) {
-    rehash(data.size());
-    num_deleted = 0;
-  }
 
-  size_t hash = hasher(key);
-  size_t i = 0;
-  size_t index = probe(hash, i, data.size());
-
-  while (data[index].state != EntryState::EMPTY) {
-    if (data[index].state == EntryState::OCCUPIED && data[index].key == key) {
-      data[index].state = EntryState::DELETED;
-      --num_elements;
-      ++num_deleted;
-      return 1;
-    }
-    ++i;
-    index = probe(hash, i, data.size());
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename Q>
+typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                 Allocator, GrowthPolicy>::size_type
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                        GrowthPolicy>::erase_hashed(const Q &key, size_t hash) {
+  // The tombstone sweep also shrinks a table that has drained, to a
+  // capacity at most half full so that regrowing is not imminent.
+  if (static_cast<float>(num_deleted) / data.size() > max_tombstones) {
+    rehash(std::min(data.size(), capacity_for(2 * num_elements)));
   }
-  return 0;
-}
 
-template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
-typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::iterator
-OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::find(key_type key) {
-  size_t hash = hasher(key);
-  size_t i = 0;
-  size_t index = probe(hash, i, data.size());
+  size_t index = find_index(key, hash);
+  if (index == data.size())
+    return 0;
 
-  while (data[index].state != EntryState::EMPTY) {
-    if (data[index].state == EntryState::OCCUPIED && data[index].key == key)
-      return iterator(&*(data.begin() + index), &data.back() + 1);
+  set_ctrl(index, CTRL_DELETED);
+  --num_elements;
+  ++num_deleted;
+  return 1;
+}
 
-    ++i;
-    index = probe(hash, i, data.size());
-  }
-  return end();
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                             Allocator, GrowthPolicy>::erase(iterator pos) {
+  size_type index = &*pos - data.data();
+  set_ctrl(index, CTRL_DELETED);
+  --num_elements;
+  ++num_deleted;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+typename OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                                 Allocator, GrowthPolicy>::iterator
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                        GrowthPolicy>::find(const key_type &key) {
+  size_t index = find_index(key, hasher(key));
+  if (index == data.size())
+    return end();
+  return iterator_at(index);
 }
 
-template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
-void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::rehash(
-    size_type new_capacity) {
-  std::vector<Entry<K, V>> new_data(new_capacity);
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::rehash(size_type new_capacity) {
+  RehashTimer timer(telemetry);
+  std::vector<Entry<K, V>, Allocator> old_data = std::move(data);
+  std::vector<size_t, rebind_alloc<size_t>> old_hashes = std::move(hashes);
+  std::vector<ctrl_t, rebind_alloc<ctrl_t>> old_ctrl = std::move(ctrl);
+  data = std::vector<Entry<K, V>, Allocator>(new_capacity,
+                                             old_data.get_allocator());
+  ctrl.assign(control_size(new_capacity), CTRL_EMPTY);
+  hashes.assign(STORE_HASH ? new_capacity : 0, 0);
+  num_deleted = 0;
 
 #ifdef HASH_TABLE_STATISTIC
   rehashCount++;
 #endif // HASH_TABLE_STATISTIC
 
-  for (auto &entry : data) {
-    if (entry.state != EntryState::OCCUPIED)
+  for (size_t old_index = 0; old_index < old_data.size(); ++old_index) {
+    if (!is_full(old_ctrl[old_index]))
       continue;
+    Entry<K, V> &entry = old_data[old_index];
+
+    size_t hash;
+    if constexpr (STORE_HASH)
+      hash = old_hashes[old_index];
+    else
+      hash = hasher(entry.key);
+    size_t probes = 0;
+    size_t new_index = find_insert_index(hash, probes);
+#ifdef HASH_TABLE_STATISTIC
+    rehashCollisions += probes;
+#endif // HASH_TABLE_STATISTIC
+
+    data[new_index] = std::move(entry);
+    set_occupied(new_index, hash);
+  }
+}
 
-    size_t hash = hasher(entry.key);
-    size_t i = 0;
-    size_t new_index = probe(hash, i, new_data.size());
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::parallel_rehash(
+    size_type new_capacity, unsigned threads) {
+  if (threads == 0)
+    threads = default_thread_count();
+  if (threads < 2 || new_capacity < threads * PARALLEL_REHASH_MIN_SLOTS) {
+    rehash(new_capacity);
+    return;
+  }
 
-#ifdef HASH_TABLE_STATISTIC
-    if (new_data[new_index].state == EntryState::OCCUPIED)
-      rehashCollisions++;
+  RehashTimer timer(telemetry);
+  const size_type old_capacity = data.size();
+  std::vector<Entry<K, V>, Allocator> old_data = std::move(data);
+  std::vector<size_t, rebind_alloc<size_t>> old_hashes = std::move(hashes);
+  std::vector<ctrl_t, rebind_alloc<ctrl_t>> old_ctrl = std::move(ctrl);
+  data = std::vector<Entry<K, V>, Allocator>(new_capacity,
+                                             old_data.get_allocator());
+  ctrl.assign(control_size(new_capacity), CTRL_EMPTY);
+  hashes.assign(STORE_HASH ? new_capacity : 0, 0);
+  if constexpr (!STORE_HASH)
+    old_hashes.resize(old_capacity);
+  num_deleted = 0;
 
+#ifdef HASH_TABLE_STATISTIC
+  rehashCount++;
 #endif // HASH_TABLE_STATISTIC
 
-    while (new_data[new_index].state == EntryState::OCCUPIED) {
-      ++i;
-      new_index = probe(hash, i, new_data.size());
+  // Thread t owns new slots [t * span, (t + 1) * span). Entries are first
+  // bucketed by the range of their home slot, then every thread places its
+  // own bucket, writing only inside its range.
+  const size_type span = (new_capacity + threads - 1) / threads;
+  std::vector<size_type> order, bucket_begin;
+  partition_by_home(
+      threads, old_capacity, new_capacity,
+      [&](size_type i) { return !is_full(old_ctrl[i]); },
+      [&](size_type i) -> size_t {
+        if constexpr (STORE_HASH)
+          return old_hashes[i];
+        else
+          return hasher(old_data[i].key);
+      },
+      old_hashes.data(), order, bucket_begin);
+
+  // A probe that leaves the thread's range is deferred to the serial pass
+  // below. Every slot a placed entry skipped was already full, and slots
+  // only ever fill, so lookups find it whatever the placement order.
+  std::vector<std::vector<size_type>> deferred(threads);
+  std::vector<size_t> collisions(threads, 0);
+  run_in_parallel(threads, [&](unsigned t) {
+    const size_type low = t * span;
+    const size_type high = std::min(new_capacity, low + span);
+    size_t skipped = 0;
+    for (size_type k = bucket_begin[t]; k < bucket_begin[t + 1]; ++k) {
+      size_type old_index = order[k];
+      size_t hash = old_hashes[old_index];
+      bool placed = false;
+      size_t i = 0;
+      for (; i < new_capacity; ++i) {
+        size_type index = probe(hash, i, new_capacity);
+        if (index < low || index >= high)
+          break;
+        if (!is_full(ctrl[index])) {
+          data[index] = std::move(old_data[old_index]);
+          set_occupied(index, hash);
+          placed = true;
+          break;
+        }
+      }
+      skipped += i;
+      if (!placed)
+        deferred[t].push_back(old_index);
+    }
+    collisions[t] = skipped;
+  });
+
+  for (unsigned t = 0; t < threads; ++t) {
+#ifdef HASH_TABLE_STATISTIC
+    rehashCollisions += collisions[t];
+#endif // HASH_TABLE_STATISTIC
+    for (size_type old_index : deferred[t]) {
+      size_t hash = old_hashes[old_index];
+      size_t probes = 0;
+      size_type index = find_insert_index(hash, probes);
 #ifdef HASH_TABLE_STATISTIC
-      rehashCollisions++;
+      rehashCollisions += probes;
 #endif // HASH_TABLE_STATISTIC
+      data[index] = std::move(old_data[old_index]);
+      set_occupied(index, hash);
     }
+  }
+}
 
-    new_data[new_index] = entry;
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename Skip, typename HashOf>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::partition_by_home(
+    unsigned threads, size_type count, size_type capacity, Skip skip,
+    HashOf hash_of, size_t *item_hashes, std::vector<size_type> &order,
+    std::vector<size_type> &bucket_begin) const {
+  // Thread t reads items [t * chunk, (t + 1) * chunk): a first pass counts
+  // where they go, a second writes their indices into place.
+  const size_type chunk = (count + threads - 1) / threads;
+  const size_type span = (capacity + threads - 1) / threads;
+  auto owner = [&](size_t hash) { return probe(hash, 0, capacity) / span; };
+
+  // counts[src * threads + dst]: items read by src whose home is in dst.
+  std::vector<size_type> counts(size_type(threads) * threads, 0);
+  run_in_parallel(threads, [&](unsigned t) {
+    size_type *row = &counts[size_type(t) * threads];
+    size_type end = std::min(count, (t + 1) * chunk);
+    for (size_type i = std::min(count, t * chunk); i < end; ++i) {
+      if (skip(i))
+        continue;
+      item_hashes[i] = hash_of(i);
+      ++row[owner(item_hashes[i])];
+    }
+  });
+
+  bucket_begin.assign(threads + 1, 0);
+  size_type total = 0;
+  for (unsigned dst = 0; dst < threads; ++dst) {
+    bucket_begin[dst] = total;
+    for (unsigned src = 0; src < threads; ++src) {
+      size_type items = counts[size_type(src) * threads + dst];
+      counts[size_type(src) * threads + dst] = total;
+      total += items;
+    }
+  }
+  bucket_begin[threads] = total;
+
+  order.resize(total);
+  run_in_parallel(threads, [&](unsigned t) {
+    size_type *next = &counts[size_type(t) * threads];
+    size_type end = std::min(count, (t + 1) * chunk);
+    for (size_type i = std::min(count, t * chunk); i < end; ++i)
+      if (!skip(i))
+        order[next[owner(item_hashes[i])]++] = i;
+  });
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename RandomIt>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::parallel_build(RandomIt first,
+                                                           RandomIt last,
+                                                           unsigned threads) {
+  if (threads == 0)
+    threads = default_thread_count();
+  const size_type count = static_cast<size_type>(last - first);
+  reserve(num_elements + count);
+  const size_type capacity = data.size();
+  if (threads < 2 || capacity < threads * PARALLEL_REHASH_MIN_SLOTS) {
+    bulk_insert(first, last);
+    return;
   }
 
-  data = std::move(new_data);
+  std::vector<size_t> item_hashes(count);
+  std::vector<size_type> order, bucket_begin;
+  partition_by_home(
+      threads, count, capacity, [](size_type) { return false; },
+      [&](size_type i) -> size_t { return hasher(first[i].first); },
+      item_hashes.data(), order, bucket_begin);
+
+  // Placement works as in parallel_rehash, except that the table may
+  // already hold keys and the input may repeat them. Every copy of a key
+  // belongs to one thread and comes in input order, so the first placed
+  // wins. Nothing is erased meanwhile, so a probe that reaches an EMPTY slot
+  // has passed every slot the key could be in; tombstones are passed over
+  // and never reused.
+  const size_type span = (capacity + threads - 1) / threads;
+  std::vector<std::vector<size_type>> deferred(threads);
+  std::vector<size_type> added(threads, 0);
+  run_in_parallel(threads, [&](unsigned t) {
+    const size_type low = t * span;
+    const size_type high = std::min(capacity, low + span);
+    for (size_type k = bucket_begin[t]; k < bucket_begin[t + 1]; ++k) {
+      const size_type item = order[k];
+      const size_t hash = item_hashes[item];
+      const ctrl_t tag = ctrl_tag(hash);
+      bool done = false;
+      for (size_t i = 0; i < capacity; ++i) {
+        size_type index = probe(hash, i, capacity);
+        if (index < low || index >= high)
+          break;
+        if (ctrl[index] == CTRL_EMPTY) {
+          data[index].value = first[item].second;
+          data[index].key = first[item].first;
+          set_occupied(index, hash);
+          ++added[t];
+          done = true;
+          break;
+        }
+        if (ctrl[index] == tag && data[index].key == first[item].first) {
+          done = true;
+          break;
+        }
+      }
+      if (!done)
+        deferred[t].push_back(item);
+    }
+  });
+
+  for (unsigned t = 0; t < threads; ++t)
+    num_elements += added[t];
+  for (unsigned t = 0; t < threads; ++t)
+    for (size_type item : deferred[t])
+      try_emplace_hashed(first[item].first, item_hashes[item],
+                         first[item].second);
 }
 
-template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
-void OpenAddressingHashTable<K, V, HashFunction,
-                             ProbingPolicy>::clear() noexcept {
-  for (auto &entry : data)
-    entry.state = EntryState::EMPTY;
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+std::vector<typename OpenAddressingHashTable<
+    K, V, HashFunction, ProbingPolicy, Allocator, GrowthPolicy>::SlotRange>
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                        GrowthPolicy>::slot_ranges(size_type n) const {
+  const size_type capacity = data.size();
+  size_type step = (capacity + std::max<size_type>(n, 1) - 1) /
+                   std::max<size_type>(n, 1);
+  step = (step + Group::WIDTH - 1) / Group::WIDTH * Group::WIDTH;
+
+  std::vector<SlotRange> ranges;
+  for (size_type begin = 0; begin < capacity; begin += step)
+    ranges.push_back({begin, std::min(capacity, begin + step)});
+  return ranges;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename F>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::
+    for_each_full(SlotRange range, F f, const std::atomic<bool> *stop) const {
+  // A group may start anywhere below the capacity: the mirrored bytes past
+  // the end keep the load in bounds, and offsets past range.end are cut.
+  for (size_type group = range.begin; group < range.end;
+       group += Group::WIDTH) {
+    if (stop && stop->load(std::memory_order_relaxed))
+      return;
+    for (uint32_t offset : Group(ctrl.data() + group).match_full()) {
+      if (group + offset >= range.end)
+        break;
+      f(group + offset);
+    }
+  }
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename F>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::for_each(SlotRange range, F f) {
+  for_each_full(range, [&](size_type index) { f(data[index]); });
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename F>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::for_each(SlotRange range,
+                                                     F f) const {
+  for_each_full(range, [&](size_type index) { f(data[index]); });
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename F>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::parallel_for_each(
+    F f, unsigned threads) {
+  std::vector<SlotRange> ranges = slot_ranges(scan_threads(threads));
+  if (ranges.empty())
+    return;
+  run_in_parallel(static_cast<unsigned>(ranges.size()),
+                  [&](unsigned t) { for_each(ranges[t], f); });
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+template <typename T, typename Map, typename Combine>
+T OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                          GrowthPolicy>::parallel_reduce(T init, Map map,
+                                                         Combine combine,
+                                                         unsigned threads)
+    const {
+  std::vector<SlotRange> ranges = slot_ranges(scan_threads(threads));
+  // Wrapped so that std::vector<bool> cannot pack the results into shared
+  // words.
+  struct Partial {
+    T value;
+  };
+  std::vector<Partial> partial(ranges.size(), Partial{init});
+  if (!ranges.empty())
+    run_in_parallel(static_cast<unsigned>(ranges.size()), [&](unsigned t) {
+      T value = init;
+      for_each(ranges[t], [&](const Entry<K, V> &entry) {
+        value = combine(std::move(value), map(entry));
+      });
+      partial[t].value = std::move(value);
+    });
+
+  for (Partial &p : partial)
+    init = combine(std::move(init), std::move(p.value));
+  return init;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::reserve(size_type count) {
+  size_type capacity = capacity_for(count);
+  if (capacity > data.size())
+    rehash(capacity);
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::shrink_to_fit() {
+  size_type capacity = capacity_for(num_elements);
+  if (capacity < data.size() || num_deleted != 0)
+    rehash(std::min(capacity, data.size()));
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::max_load_factor(float factor) {
+  if (!(factor > 0.0f && factor < 1.0f))
+    throw std::invalid_argument("max_load_factor(): must be in (0, 1)");
+  max_load = factor;
+  if (static_cast<float>(num_elements) / data.size() > max_load)
+    rehash(capacity_for(num_elements));
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::max_tombstone_factor(float factor) {
+  if (!(factor > 0.0f && factor < 1.0f))
+    throw std::invalid_argument("max_tombstone_factor(): must be in (0, 1)");
+  max_tombstones = factor;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+TelemetrySnapshot
+OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                        GrowthPolicy>::telemetry_snapshot() const {
+  TelemetrySnapshot result;
+  if (telemetry)
+    result = telemetry->snapshot();
+  result.size = num_elements;
+  result.capacity = data.size();
+  result.tombstones = num_deleted;
+  result.load_factor = static_cast<float>(num_elements) / data.size();
+  result.tombstone_ratio = static_cast<float>(num_deleted) / data.size();
+  return result;
+}
+
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy,
+                             Allocator, GrowthPolicy>::clear() noexcept {
+  std::fill(ctrl.begin(), ctrl.end(), CTRL_EMPTY);
 
   num_elements = 0;
   num_deleted = 0;
 }
 
-template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
-bool OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::contains(
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+bool OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::contains(
     const key_type &key) const {
-  size_t hash = hasher(key);
-  size_t i = 0;
-  size_t index = probe(hash, i, data.size());
-
-  while (data[index].state != EntryState::EMPTY) {
-    if (data[index].state == EntryState::OCCUPIED && data[index].key == key)
-      return true;
-
-    ++i;
-    index = probe(hash, i, data.size());
-  }
-  return false;
+  return find_index(key, hasher(key)) != data.size();
 }
 
-template <typename K, typename V, typename HashFunction, typename ProbingPolicy>
-void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>::swap(
-    OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy> &other) {
+template <typename K, typename V, typename HashFunction, typename ProbingPolicy,
+          typename Allocator, typename GrowthPolicy>
+void OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy, Allocator,
+                             GrowthPolicy>::swap(
+    OpenAddressingHashTable &other) {
   std::swap(num_elements, other.num_elements);
   std::swap(num_deleted, other.num_deleted);
+  std::swap(max_load, other.max_load);
+  std::swap(max_tombstones, other.max_tombstones);
+  std::swap(telemetry, other.telemetry);
   std::swap(hasher, other.hasher);
   std::swap(probe, other.probe);
   std::swap(data, other.data);
+  std::swap(ctrl, other.ctrl);
+  std::swap(hashes, other.hashes);
 }
+
+#include "frozen_hash_table.h"
+#if __has_include(<sys/mman.h>)
+#include "hash_table_snapshot.h"
+#endif
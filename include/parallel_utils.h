@@ -0,0 +1,21 @@
+#pragma once
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Thread count used when a parallel operation is passed 0.
+inline unsigned default_thread_count() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Runs f(0) .. f(threads - 1) concurrently, f(0) on the calling thread, and
+// returns once every call has finished.
+template <typename F> void run_in_parallel(unsigned threads, F f) {
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (unsigned t = 1; t < threads; ++t)
+    workers.emplace_back([&f, t] { f(t); });
+  f(0u);
+  for (auto &worker : workers)
+    worker.join();
+}
@@ -0,0 +1,408 @@
+#pragma once
+#include "open_addressing_hash_table.h"
+#include <cstdint>
+#include <utility>
+
+// Linear probing where every slot remembers how far it sits from its home
+// slot. An insert takes the slot of any entry that is closer to home than
+// itself, so a lookup can stop as soon as it meets such an entry, and erase
+// shifts the rest of the cluster back instead of leaving a DELETED tombstone.
+template <typename K, typename V, typename HashFunction = std::hash<K>> //
+class RobinHoodHashTable {
+public:
+  // Usings for STD cointainers
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = Entry<K, V>;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using pointer = value_type *;
+  using const_pointer = const value_type *;
+
+  using iterator = EntryIterator<K, V>;
+
+  RobinHoodHashTable() : data(4), distances(4, 0), num_elements(0) {}
+  RobinHoodHashTable(std::initializer_list<std::pair<const K, V>> init)
+      : RobinHoodHashTable() {
+    for (auto &p : init)
+      insert(p.first, p.second);
+  }
+  RobinHoodHashTable(RobinHoodHashTable &&other)
+      : data(std::move(other.data)), distances(std::move(other.distances)),
+        hasher(std::move(other.hasher)), num_elements(other.num_elements) {
+    other.num_elements = 0;
+  }
+  RobinHoodHashTable(const RobinHoodHashTable &other) = default;
+
+  iterator begin() noexcept {
+    return iterator(data.data(), data.data() + data.size());
+  };
+  iterator end() noexcept {
+    return iterator(data.data() + data.size(), data.data() + data.size());
+  };
+
+  // Insertions never overwrite: when the key is already present the
+  // returned iterator points at the existing entry and the flag is false.
+  std::pair<iterator, bool> insert(key_type key, mapped_type value);
+  template <typename KeyArg, typename... Args>
+  std::pair<iterator, bool> emplace(KeyArg &&key, Args &&...args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type &key, Args &&...args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type &&key, Args &&...args);
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&value);
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&value);
+  size_type erase(const key_type &key);
+  iterator find(const key_type &key);
+
+  void operator=(const RobinHoodHashTable &other);
+  void operator=(RobinHoodHashTable &&other);
+
+  bool operator==(RobinHoodHashTable &other);
+  bool operator!=(RobinHoodHashTable &other) { return !(*this == other); }
+
+  mapped_type &operator[](const key_type &key);
+  mapped_type &at(const key_type &key);
+
+  void rehash(size_type new_capacity);
+
+  std::vector<Entry<K, V>> get_container() const { return data; }
+
+  size_type size() const noexcept { return num_elements; }
+  bool empty() const noexcept { return num_elements == 0; }
+
+  void clear() noexcept;
+  bool contains(const key_type &key) const;
+
+  void swap(RobinHoodHashTable<K, V, HashFunction> &other);
+
+  // Longest distance from home over all entries; bounds every lookup.
+  size_type max_probe_length() const;
+
+  // Heterogeneous lookup, only offered when HashFunction is transparent, as
+  // in OpenAddressingHashTable.
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  iterator find(const Q &key) {
+    return iterator_at(find_index(key, hasher(key)));
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  bool contains(const Q &key) const {
+    return find_index(key, hasher(key)) != data.size();
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  mapped_type &at(const Q &key) {
+    size_type index = find_index(key, hasher(key));
+    if (index == data.size())
+      throw std::out_of_range("function at(): key was not found");
+    return data[index].value;
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  size_type erase(const Q &key) {
+    return erase_at(find_index(key, hasher(key)));
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  mapped_type &operator[](const Q &key) {
+    return try_emplace_hashed(key, hasher(key)).first->value;
+  }
+  template <typename Q, typename H = HashFunction,
+            typename = std::enable_if_t<is_transparent<H>::value>>
+  std::pair<iterator, bool> insert(const Q &key, mapped_type value) {
+    return try_emplace_hashed(key, hasher(key), std::move(value));
+  }
+
+  std::vector<Entry<K, V>> data;
+  // 0 for an empty slot, otherwise distance from the home slot plus one.
+  std::vector<uint32_t> distances;
+  HashFunction hasher;
+  size_t num_elements;
+
+private:
+  size_type home(size_t hash) const { return hash & (data.size() - 1); }
+  size_type next(size_type index) const {
+    return (index + 1) & (data.size() - 1);
+  }
+  bool needs_grow() const {
+    return data.empty() ||
+           static_cast<float>(num_elements) / data.size() > LOAD_FACTOR;
+  }
+  void grow() { rehash(data.empty() ? 4 : data.size() * 2); }
+
+  iterator iterator_at(size_type index) {
+    return iterator(data.data() + index, data.data() + data.size());
+  }
+
+  // Slot holding key, or data.size() if it is absent.
+  template <typename Q> size_type find_index(const Q &key, size_t hash) const;
+  size_type find_index(const key_type &key) const {
+    return find_index(key, hasher(key));
+  }
+  // Places an entry known to be absent, displacing richer entries.
+  size_type place(Entry<K, V> entry, size_t hash);
+  // Looks key up and, if it is missing, stores key_type(key) together with
+  // mapped_type(args...). Nothing is constructed when the key exists.
+  template <typename KeyArg, typename... Args>
+  std::pair<iterator, bool> try_emplace_hashed(KeyArg &&key, size_t hash,
+                                               Args &&...args);
+  // Empties the slot at index; index may be data.size().
+  size_type erase_at(size_type index);
+};
+
+template <typename K, typename V, typename HashFunction>
+template <typename Q>
+typename RobinHoodHashTable<K, V, HashFunction>::size_type
+RobinHoodHashTable<K, V, HashFunction>::find_index(const Q &key,
+                                                   size_t hash) const {
+  if (data.empty())
+    return 0;
+
+  size_type index = home(hash);
+  for (uint32_t distance = 1; distances[index] >= distance; ++distance) {
+    if (distances[index] == distance && data[index].key == key)
+      return index;
+    index = next(index);
+  }
+  return data.size();
+}
+
+template <typename K, typename V, typename HashFunction>
+typename RobinHoodHashTable<K, V, HashFunction>::size_type
+RobinHoodHashTable<K, V, HashFunction>::place(Entry<K, V> entry, size_t hash) {
+  size_type index = home(hash);
+  uint32_t distance = 1;
+  size_type placed = data.size();
+
+  entry.state = EntryState::OCCUPIED;
+  while (distances[index] != 0) {
+    if (distances[index] < distance) {
+      std::swap(entry, data[index]);
+      std::swap(distance, distances[index]);
+      if (placed == data.size())
+        placed = index;
+    }
+    index = next(index);
+    ++distance;
+  }
+
+  data[index] = std::move(entry);
+  distances[index] = distance;
+  num_elements++;
+  return placed == data.size() ? index : placed;
+}
+
+template <typename K, typename V, typename HashFunction>
+template <typename KeyArg, typename... Args>
+std::pair<typename RobinHoodHashTable<K, V, HashFunction>::iterator, bool>
+RobinHoodHashTable<K, V, HashFunction>::try_emplace_hashed(KeyArg &&key,
+                                                           size_t hash,
+                                                           Args &&...args) {
+  size_type index = find_index(key, hash);
+  if (index != data.size())
+    return {iterator_at(index), false};
+  if (needs_grow())
+    grow();
+
+  index = place(Entry<K, V>{key_type(std::forward<KeyArg>(key)),
+                            mapped_type(std::forward<Args>(args)...)},
+                hash);
+  return {iterator_at(index), true};
+}
+
+template <typename K, typename V, typename HashFunction>
+std::pair<typename RobinHoodHashTable<K, V, HashFunction>::iterator, bool>
+RobinHoodHashTable<K, V, HashFunction>::insert(key_type key,
+                                               mapped_type value) {
+  size_t hash = hasher(key);
+  return try_emplace_hashed(std::move(key), hash, std::move(value));
+}
+
+template <typename K, typename V, typename HashFunction>
+template <typename KeyArg, typename... Args>
+std::pair<typename RobinHoodHashTable<K, V, HashFunction>::iterator, bool>
+RobinHoodHashTable<K, V, HashFunction>::emplace(KeyArg &&key,
+                                                Args &&...args) {
+  key_type new_key(std::forward<KeyArg>(key));
+  size_t hash = hasher(new_key);
+  return try_emplace_hashed(std::move(new_key), hash,
+                            std::forward<Args>(args)...);
+}
+
+template <typename K, typename V, typename HashFunction>
+template <typename... Args>
+std::pair<typename RobinHoodHashTable<K, V, HashFunction>::iterator, bool>
+RobinHoodHashTable<K, V, HashFunction>::try_emplace(const key_type &key,
+                                                    Args &&...args) {
+  return try_emplace_hashed(key, hasher(key), std::forward<Args>(args)...);
+}
+
+template <typename K, typename V, typename HashFunction>
+template <typename... Args>
+std::pair<typename RobinHoodHashTable<K, V, HashFunction>::iterator, bool>
+RobinHoodHashTable<K, V, HashFunction>::try_emplace(key_type &&key,
+                                                    Args &&...args) {
+  size_t hash = hasher(key);
+  return try_emplace_hashed(std::move(key), hash, std::forward<Args>(args)...);
+}
+
+template <typename K, typename V, typename HashFunction>
+template <typename M>
+std::pair<typename RobinHoodHashTable<K, V, HashFunction>::iterator, bool>
+RobinHoodHashTable<K, V, HashFunction>::insert_or_assign(const key_type &key,
+                                                         M &&value) {
+  auto result = try_emplace_hashed(key, hasher(key), std::forward<M>(value));
+  if (!result.second)
+    result.first->value = std::forward<M>(value);
+  return result;
+}
+
+template <typename K, typename V, typename HashFunction>
+template <typename M>
+std::pair<typename RobinHoodHashTable<K, V, HashFunction>::iterator, bool>
+RobinHoodHashTable<K, V, HashFunction>::insert_or_assign(key_type &&key,
+                                                         M &&value) {
+  size_t hash = hasher(key);
+  auto result =
+      try_emplace_hashed(std::move(key), hash, std::forward<M>(value));
+  if (!result.second)
+    result.first->value = std::forward<M>(value);
+  return result;
+}
+
+/// ================== OPERATORS ================
+template <typename K, typename V, typename HashFunction>
+typename RobinHoodHashTable<K, V, HashFunction>::mapped_type &
+RobinHoodHashTable<K, V, HashFunction>::operator[](const key_type &key) {
+  return try_emplace_hashed(key, hasher(key)).first->value;
+}
+
+template <typename K, typename V, typename HashFunction>
+void RobinHoodHashTable<K, V, HashFunction>::operator=(
+    const RobinHoodHashTable &other) {
+  data = other.data;
+  distances = other.distances;
+  hasher = other.hasher;
+  num_elements = other.num_elements;
+}
+
+template <typename K, typename V, typename HashFunction>
+void RobinHoodHashTable<K, V, HashFunction>::operator=(
+    RobinHoodHashTable &&other) {
+  data = std::move(other.data);
+  distances = std::move(other.distances);
+  hasher = std::move(other.hasher);
+  num_elements = other.num_elements;
+
+  other.num_elements = 0;
+}
+
+template <typename K, typename V, typename HashFunction>
+bool RobinHoodHashTable<K, V, HashFunction>::operator==(
+    RobinHoodHashTable &other) {
+  if (other.num_elements != num_elements)
+    return false;
+
+  for (auto &entry : *this) {
+    iterator it = other.find(entry.key);
+    if (it == other.end() || it->value != entry.value)
+      return false;
+  }
+  return true;
+}
+
+template <typename K, typename V, typename HashFunction>
+typename RobinHoodHashTable<K, V, HashFunction>::mapped_type &
+RobinHoodHashTable<K, V, HashFunction>::at(const key_type &key) {
+  size_type index = find_index(key);
+  if (index == data.size())
+    throw std::out_of_range("function at(): key was not found");
+  return data[index].value;
+}
+
+template <typename K, typename V, typename HashFunction>
+typename RobinHoodHashTable<K, V, HashFunction>::size_type
+RobinHoodHashTable<K, V, HashFunction>::erase(const key_type &key) {
+  return erase_at(find_index(key));
+}
+
+template <typename K, typename V, typename HashFunction>
+typename RobinHoodHashTable<K, V, HashFunction>::size_type
+RobinHoodHashTable<K, V, HashFunction>::erase_at(size_type index) {
+  if (index == data.size())
+    return 0;
+
+  // Backward shift: pull every displaced successor one slot closer to home.
+  size_type following = next(index);
+  while (distances[following] > 1) {
+    data[index] = std::move(data[following]);
+    distances[index] = distances[following] - 1;
+    index = following;
+    following = next(following);
+  }
+
+  data[index].state = EntryState::EMPTY;
+  distances[index] = 0;
+  --num_elements;
+  return 1;
+}
+
+template <typename K, typename V, typename HashFunction>
+typename RobinHoodHashTable<K, V, HashFunction>::iterator
+RobinHoodHashTable<K, V, HashFunction>::find(const key_type &key) {
+  return iterator_at(find_index(key));
+}
+
+template <typename K, typename V, typename HashFunction>
+void RobinHoodHashTable<K, V, HashFunction>::rehash(size_type new_capacity) {
+  std::vector<Entry<K, V>> old_data = std::move(data);
+  data = std::vector<Entry<K, V>>(new_capacity);
+  distances.assign(new_capacity, 0);
+  num_elements = 0;
+
+  for (auto &entry : old_data) {
+    if (entry.state != EntryState::OCCUPIED)
+      continue;
+    size_t hash = hasher(entry.key);
+    place(std::move(entry), hash);
+  }
+}
+
+template <typename K, typename V, typename HashFunction>
+void RobinHoodHashTable<K, V, HashFunction>::clear() noexcept {
+  for (auto &entry : data)
+    entry.state = EntryState::EMPTY;
+  std::fill(distances.begin(), distances.end(), 0);
+
+  num_elements = 0;
+}
+
+template <typename K, typename V, typename HashFunction>
+bool RobinHoodHashTable<K, V, HashFunction>::contains(
+    const key_type &key) const {
+  return find_index(key) != data.size();
+}
+
+template <typename K, typename V, typename HashFunction>
+void RobinHoodHashTable<K, V, HashFunction>::swap(
+    RobinHoodHashTable<K, V, HashFunction> &other) {
+  std::swap(num_elements, other.num_elements);
+  std::swap(hasher, other.hasher);
+  std::swap(data, other.data);
+  std::swap(distances, other.distances);
+}
+
+template <typename K, typename V, typename HashFunction>
+typename RobinHoodHashTable<K, V, HashFunction>::size_type
+RobinHoodHashTable<K, V, HashFunction>::max_probe_length() const {
+  uint32_t longest = 0;
+  for (uint32_t distance : distances)
+    longest = std::max(longest, distance);
+  return longest == 0 ? 0 : longest - 1;
+}
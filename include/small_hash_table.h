@@ -0,0 +1,268 @@
+#pragma once
+#include "open_addressing_hash_table.h"
+#include <memory>
+
+// Map for tables that are usually tiny, such as per-object attribute maps.
+// Up to N entries live inline in the object, packed at the front of an array
+// and found by a linear scan over the keys: no allocation, no hashing, and
+// for small N the whole map shares a cache line or two with its owner.
+// Inserting entry N + 1 moves everything into a heap OpenAddressingHashTable,
+// which serves all calls from then on; clear() and shrink_to_fit() (once the
+// size is back to N or below) return to inline storage.
+//
+// Iterators and references are invalidated by every insert and erase: inline
+// erase moves the last entry into the hole.
+template <typename K, typename V, size_t N = 8,
+          typename HashFunction = std::hash<K>,
+          typename ProbingPolicy = LinearHashing<K>> //
+class SmallHashTable {
+  static_assert(N > 0, "SmallHashTable needs room for one inline entry");
+
+public:
+  using table_type = OpenAddressingHashTable<K, V, HashFunction, ProbingPolicy>;
+
+  static constexpr size_t INLINE_CAPACITY = N;
+
+  // Usings for STD cointainers
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = Entry<K, V>;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using pointer = value_type *;
+  using const_pointer = const value_type *;
+
+  using iterator = typename table_type::iterator;
+
+  SmallHashTable() = default;
+  SmallHashTable(std::initializer_list<std::pair<const K, V>> init) {
+    for (auto &p : init)
+      insert(p.first, p.second);
+  }
+  SmallHashTable(const SmallHashTable &other) { *this = other; }
+  SmallHashTable(SmallHashTable &&other) { *this = std::move(other); }
+  void operator=(const SmallHashTable &other);
+  void operator=(SmallHashTable &&other);
+
+  iterator begin() noexcept {
+    if (table)
+      return table->begin();
+    return iterator_at(0);
+  }
+  iterator end() noexcept {
+    if (table)
+      return table->end();
+    return iterator_at(count);
+  }
+
+  std::pair<iterator, bool> insert(key_type key, mapped_type value) {
+    return try_emplace(std::move(key), std::move(value));
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type key, Args &&...args);
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type key, M &&value);
+  size_type erase(const key_type &key);
+  iterator find(const key_type &key);
+
+  mapped_type &operator[](const key_type &key) {
+    return try_emplace(key).first->value;
+  }
+  mapped_type &at(const key_type &key);
+  bool contains(const key_type &key) const {
+    if (table)
+      return table->contains(key);
+    return find_inline(key) != count;
+  }
+
+  size_type size() const noexcept { return table ? table->size() : count; }
+  bool empty() const noexcept { return size() == 0; }
+  // N while inline.
+  size_type bucket_count() const noexcept {
+    return table ? table->bucket_count() : N;
+  }
+  // True until the table first outgrows N entries (or after it is cleared).
+  bool is_inline() const noexcept { return !table; }
+
+  // Goes to the heap table right away when count exceeds N.
+  void reserve(size_type count);
+  // Back to inline storage if the entries fit, else shrinks the heap table.
+  void shrink_to_fit();
+  void clear() noexcept;
+
+private:
+  Entry<K, V> items[N];
+  size_type count = 0;
+  std::unique_ptr<table_type> table;
+  // Control bytes for the inline entries, which are all full, so that they
+  // share the heap table's iterator.
+  static constexpr ctrl_t INLINE_CTRL[N] = {};
+
+  // Index of key in items, or count.
+  size_type find_inline(const key_type &key) const {
+    for (size_type i = 0; i < count; ++i)
+      if (items[i].key == key)
+        return i;
+    return count;
+  }
+  iterator iterator_at(size_type index) {
+    return iterator(items + index, items + count, INLINE_CTRL + index);
+  }
+  // Moves the inline entries into a heap table sized for capacity_hint.
+  void spill(size_type capacity_hint);
+};
+
+template <typename K, typename V, size_t N, typename HashFunction,
+          typename ProbingPolicy>
+void SmallHashTable<K, V, N, HashFunction, ProbingPolicy>::operator=(
+    const SmallHashTable &other) {
+  if (this == &other)
+    return;
+  clear();
+  if (other.table) {
+    table = std::make_unique<table_type>(*other.table);
+    return;
+  }
+  for (size_type i = 0; i < other.count; ++i)
+    items[i] = other.items[i];
+  count = other.count;
+}
+
+template <typename K, typename V, size_t N, typename HashFunction,
+          typename ProbingPolicy>
+void SmallHashTable<K, V, N, HashFunction, ProbingPolicy>::operator=(
+    SmallHashTable &&other) {
+  if (this == &other)
+    return;
+  clear();
+  table = std::move(other.table);
+  for (size_type i = 0; i < other.count; ++i)
+    items[i] = std::move(other.items[i]);
+  count = other.count;
+  other.clear();
+}
+
+template <typename K, typename V, size_t N, typename HashFunction,
+          typename ProbingPolicy>
+void SmallHashTable<K, V, N, HashFunction, ProbingPolicy>::spill(
+    size_type capacity_hint) {
+  auto heap = std::make_unique<table_type>(capacity_hint);
+  for (size_type i = 0; i < count; ++i) {
+    heap->try_emplace(std::move(items[i].key), std::move(items[i].value));
+    items[i] = Entry<K, V>();
+  }
+  count = 0;
+  table = std::move(heap);
+}
+
+template <typename K, typename V, size_t N, typename HashFunction,
+          typename ProbingPolicy>
+template <typename... Args>
+std::pair<typename SmallHashTable<K, V, N, HashFunction,
+                                  ProbingPolicy>::iterator,
+          bool>
+SmallHashTable<K, V, N, HashFunction, ProbingPolicy>::try_emplace(
+    key_type key, Args &&...args) {
+  if (!table) {
+    size_type index = find_inline(key);
+    if (index != count)
+      return {iterator_at(index), false};
+    if (count < N) {
+      items[count].key = std::move(key);
+      items[count].value = V(std::forward<Args>(args)...);
+      ++count;
+      return {iterator_at(count - 1), true};
+    }
+    spill(2 * N);
+  }
+  return table->try_emplace(std::move(key), std::forward<Args>(args)...);
+}
+
+template <typename K, typename V, size_t N, typename HashFunction,
+          typename ProbingPolicy>
+template <typename M>
+std::pair<typename SmallHashTable<K, V, N, HashFunction,
+                                  ProbingPolicy>::iterator,
+          bool>
+SmallHashTable<K, V, N, HashFunction, ProbingPolicy>::insert_or_assign(
+    key_type key, M &&value) {
+  auto result = try_emplace(std::move(key), std::forward<M>(value));
+  if (!result.second)
+    result.first->value = std::forward<M>(value);
+  return result;
+}
+
+template <typename K, typename V, size_t N, typename HashFunction,
+          typename ProbingPolicy>
+typename SmallHashTable<K, V, N, HashFunction, ProbingPolicy>::size_type
+SmallHashTable<K, V, N, HashFunction, ProbingPolicy>::erase(
+    const key_type &key) {
+  if (table)
+    return table->erase(key);
+  size_type index = find_inline(key);
+  if (index == count)
+    return 0;
+  --count;
+  if (index != count)
+    items[index] = std::move(items[count]);
+  items[count] = Entry<K, V>();
+  return 1;
+}
+
+template <typename K, typename V, size_t N, typename HashFunction,
+          typename ProbingPolicy>
+typename SmallHashTable<K, V, N, HashFunction, ProbingPolicy>::iterator
+SmallHashTable<K, V, N, HashFunction, ProbingPolicy>::find(
+    const key_type &key) {
+  if (table)
+    return table->find(key);
+  return iterator_at(find_inline(key));
+}
+
+template <typename K, typename V, size_t N, typename HashFunction,
+          typename ProbingPolicy>
+V &SmallHashTable<K, V, N, HashFunction, ProbingPolicy>::at(
+    const key_type &key) {
+  auto it = find(key);
+  if (it == end())
+    throw std::out_of_range("function at(): key was not found");
+  return it->value;
+}
+
+template <typename K, typename V, size_t N, typename HashFunction,
+          typename ProbingPolicy>
+void SmallHashTable<K, V, N, HashFunction, ProbingPolicy>::reserve(
+    size_type count) {
+  if (table)
+    table->reserve(count);
+  else if (count > N)
+    spill(count);
+}
+
+template <typename K, typename V, size_t N, typename HashFunction,
+          typename ProbingPolicy>
+void SmallHashTable<K, V, N, HashFunction, ProbingPolicy>::shrink_to_fit() {
+  if (!table)
+    return;
+  if (table->size() > N) {
+    table->shrink_to_fit();
+    return;
+  }
+  std::unique_ptr<table_type> heap = std::move(table);
+  for (auto &entry : *heap) {
+    items[count].key = std::move(entry.key);
+    items[count].value = std::move(entry.value);
+    ++count;
+  }
+}
+
+template <typename K, typename V, size_t N, typename HashFunction,
+          typename ProbingPolicy>
+void SmallHashTable<K, V, N, HashFunction, ProbingPolicy>::clear() noexcept {
+  table.reset();
+  for (size_type i = 0; i < count; ++i)
+    items[i] = Entry<K, V>();
+  count = 0;
+}
@@ -94,6 +94,19 @@ void testIntLinear(StatisticWriter &stat) {
   }
 }
 
+void testIntLinearFibonacci(StatisticWriter &stat) {
+  OpenAddressingHashTable<int, int, Hash<int>, LinearHashing<int, FibonacciMix>>
+      table;
+  for (int i = 0; i < 5000; i += 10) {
+    table.insert(i, i * 10);
+
+    if (i % 100 == 0) {
+      stat.append("int", "linear_fibonacci", i, table.getInsertCollisions(),
+                  table.getRehashCount(), table.getRehashCollisions());
+    }
+  }
+}
+
 void testIntQuadratic(StatisticWriter &stat) {
   OpenAddressingHashTable<int, int, Hash<int>, QuadraticHashing<int>>
       table;
@@ -118,6 +131,7 @@ int main() {
   // INT TESTS
   testIntDouble(stat);
   testIntLinear(stat);
+  testIntLinearFibonacci(stat);
   testIntQuadratic(stat);
 
   std::cout << "Statistics saved to hash_stats.csv\n";
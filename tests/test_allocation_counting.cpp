@@ -0,0 +1,52 @@
+// Own executable: replacing the global operator new here counts every
+// allocation of the binary, which would also see the other suites.
+#include "open_addressing_hash_table.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string_view>
+
+static std::atomic<size_t> allocation_count{0};
+
+// noinline keeps GCC from pairing an inlined free() with a new expression
+// (-Wmismatched-new-delete).
+[[gnu::noinline]] void *operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(size))
+    return ptr;
+  throw std::bad_alloc();
+}
+[[gnu::noinline]] void operator delete(void *ptr) noexcept { std::free(ptr); }
+[[gnu::noinline]] void operator delete(void *ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
+TEST(OpenAddressingHashTableTest, TransparentStringLookup) {
+  OpenAddressingHashTable<std::string, int, Hash<std::string>> table;
+  for (int i = 0; i < 100; ++i)
+    table.insert("a_rather_long_request_header_" + std::to_string(i), i);
+
+  std::string buffer = "a_rather_long_request_header_42 trailing bytes";
+  std::string_view key(buffer.data(), 31);
+  EXPECT_EQ(Hash<std::string>()(key), Hash<std::string>()(std::string(key)));
+
+  size_t before = allocation_count.load(std::memory_order_relaxed);
+  auto it = table.find(key);
+  bool found = table.contains("a_rather_long_request_header_7");
+  int value = table.at(key);
+  bool missing = table.contains(std::string_view("a_rather_long_miss"));
+  EXPECT_EQ(allocation_count.load(std::memory_order_relaxed), before);
+
+  ASSERT_NE(it, table.end());
+  EXPECT_EQ(it->value, 42);
+  EXPECT_TRUE(found);
+  EXPECT_EQ(value, 42);
+  EXPECT_FALSE(missing);
+
+  table[std::string_view("fresh")] = 5;
+  EXPECT_EQ(table.at("fresh"), 5);
+  EXPECT_EQ(table.erase(key), 1);
+  EXPECT_FALSE(table.contains(key));
+  EXPECT_THROW(table.at("a_rather_long_miss"), std::out_of_range);
+}
@@ -0,0 +1,145 @@
+#include "compact_string_hash_table.h"
+#include <gtest/gtest.h>
+#include <unordered_map>
+
+TEST(CompactStringHashTableTest, ShortAndLongKeys) {
+  CompactStringHashTable<int> table;
+  const std::string long_key = "a key that is well past the inline limit";
+
+  EXPECT_TRUE(table.insert("", 0).second);
+  EXPECT_TRUE(table.insert("short", 1).second);
+  EXPECT_TRUE(table.insert("exactly15bytes!", 2).second);
+  EXPECT_TRUE(table.insert("exactly16bytes!!", 3).second);
+  EXPECT_TRUE(table.insert(long_key, 4).second);
+  EXPECT_FALSE(table.insert("short", 11).second);
+  EXPECT_FALSE(table.insert(long_key, 44).second);
+  EXPECT_EQ(table.size(), 5u);
+  EXPECT_EQ(table.arena_bytes(), 16u + long_key.size());
+
+  EXPECT_EQ(table.at(""), 0);
+  EXPECT_EQ(table.at("short"), 1);
+  EXPECT_EQ(table.at("exactly15bytes!"), 2);
+  EXPECT_EQ(table.at("exactly16bytes!!"), 3);
+  EXPECT_EQ(table.at(long_key), 4);
+  EXPECT_FALSE(table.contains("shor"));
+  EXPECT_FALSE(table.contains("short "));
+  // Same length and prefix as long_key, different tail.
+  std::string near = long_key;
+  near.back() = '?';
+  EXPECT_FALSE(table.contains(near));
+  EXPECT_THROW(table.at(near), std::out_of_range);
+
+  EXPECT_FALSE(table.insert_or_assign(long_key, 40).second);
+  EXPECT_EQ(table.at(long_key), 40);
+  table["new"] += 7;
+  EXPECT_EQ(table.at("new"), 7);
+
+  std::unordered_map<std::string, int> seen;
+  for (auto entry : table)
+    seen[std::string(entry.key)] = entry.value;
+  EXPECT_EQ(seen.size(), 6u);
+  EXPECT_EQ(seen[long_key], 40);
+  EXPECT_EQ(seen["exactly16bytes!!"], 3);
+
+  EXPECT_EQ(table.erase(long_key), 1u);
+  EXPECT_EQ(table.erase(long_key), 0u);
+  EXPECT_FALSE(table.contains(long_key));
+  table.clear();
+  EXPECT_TRUE(table.empty());
+  EXPECT_EQ(table.arena_bytes(), 0u);
+}
+
+TEST(CompactStringHashTableTest, MatchesUnorderedMapAndCompacts) {
+  CompactStringHashTable<int> table;
+  std::unordered_map<std::string, int> reference;
+  auto key = [](int i) {
+    return i % 3 == 0 ? std::to_string(i)
+                      : "user:" + std::to_string(i) + ":profile";
+  };
+
+  for (int i = 0; i < 20000; ++i) {
+    table.insert(key(i), i);
+    reference.emplace(key(i), i);
+  }
+  for (int i = 0; i < 20000; i += 2) {
+    EXPECT_EQ(table.erase(key(i)), 1u);
+    reference.erase(key(i));
+  }
+  EXPECT_EQ(table.size(), reference.size());
+  for (int i = 0; i < 20000; ++i) {
+    auto it = table.find(key(i));
+    ASSERT_EQ(it != table.end(), i % 2 == 1) << i;
+    if (i % 2 == 1) {
+      ASSERT_EQ(it->value, i);
+    }
+  }
+
+  // Rehashing keeps only the live long keys in the arena.
+  size_t live = 0;
+  for (auto &[k, v] : reference)
+    if (k.size() > CompactKey::INLINE_MAX)
+      live += k.size();
+  table.rehash(table.bucket_count());
+  EXPECT_EQ(table.arena_bytes(), live);
+  for (auto &[k, v] : reference)
+    ASSERT_EQ(table.at(k), v);
+}
+
+TEST(CompactStringHashTableTest, KeysViewingTheArena) {
+  CompactStringHashTable<int> table;
+  auto key = [](int i) { return "session:" + std::to_string(i) + ":token"; };
+  const int N = 5000;
+  for (int i = 0; i < N; ++i)
+    table.insert(key(i), i);
+
+  // Erasing by the table's own views runs into the arena compaction.
+  for (int i = 0; i < N; i += 2) {
+    std::string_view stored = table.find(key(i))->key;
+    ASSERT_EQ(table.erase(stored), 1u) << i;
+  }
+  EXPECT_EQ(table.size(), static_cast<size_t>(N / 2));
+  for (int i = 0; i < N; ++i)
+    EXPECT_EQ(table.contains(key(i)), i % 2 == 1) << i;
+
+  // Re-inserting an erased key by its view, on the insert that grows the
+  // table: key(1) views a slot, key(1000) the arena.
+  for (int i : {1, 1000}) {
+    CompactStringHashTable<int> full;
+    while (full.size() < 2000 ||
+           static_cast<float>(full.size() + 1) / full.bucket_count() <=
+               full.max_load_factor())
+      full.insert(key(full.size()), 0);
+    std::string_view gone = full.find(key(i))->key;
+    ASSERT_EQ(full.erase(gone), 1u);
+    full.insert("filler", 0);
+    size_t capacity = full.bucket_count();
+    EXPECT_TRUE(full.insert(gone, -1).second);
+    EXPECT_GT(full.bucket_count(), capacity);
+    EXPECT_EQ(full.at(key(i)), -1);
+  }
+}
+
+TEST(CompactStringHashTableTest, LoadAndTombstoneFactors) {
+  CompactStringHashTable<int> table;
+  EXPECT_FLOAT_EQ(table.max_load_factor(), LOAD_FACTOR);
+  EXPECT_THROW(table.max_load_factor(1.0f), std::invalid_argument);
+  EXPECT_THROW(table.max_tombstone_factor(0.0f), std::invalid_argument);
+
+  for (int i = 0; i < 1000; ++i)
+    table.insert(std::to_string(i), i);
+  table.max_load_factor(0.25f);
+  EXPECT_LE(table.load_factor(), 0.25f);
+  for (int i = 1000; i < 5000; ++i) {
+    table.insert(std::to_string(i), i);
+    ASSERT_LE(table.load_factor(), 0.25f);
+  }
+
+  table.max_tombstone_factor(0.05f);
+  size_t capacity = table.bucket_count();
+  for (int i = 0; i < 5000; i += 2)
+    table.erase(std::to_string(i));
+  EXPECT_LE(table.bucket_count(), capacity);
+  EXPECT_EQ(table.size(), 2500u);
+  for (int i = 0; i < 5000; ++i)
+    EXPECT_EQ(table.contains(std::to_string(i)), i % 2 == 1);
+}
@@ -0,0 +1,84 @@
+#include "concurrent_hash_table.h"
+#include <gtest/gtest.h>
+#include <set>
+#include <thread>
+
+TEST(ConcurrentHashTableTest, BasicOperations) {
+  ConcurrentOpenAddressingHashTable<std::string, int, Hash<std::string>> table(
+      4);
+  EXPECT_EQ(table.shard_count(), 4);
+
+  EXPECT_TRUE(table.insert("one", 1));
+  EXPECT_FALSE(table.insert("one", 11));
+  EXPECT_EQ(table.find("one"), 1);
+  EXPECT_FALSE(table.insert_or_assign("one", 111));
+  EXPECT_EQ(table.find("one"), 111);
+  EXPECT_EQ(table.find("two"), std::nullopt);
+
+  EXPECT_EQ(table.erase("one"), 1);
+  EXPECT_FALSE(table.contains("one"));
+  EXPECT_TRUE(table.empty());
+}
+
+TEST(ConcurrentHashTableTest, TagsVaryInsideShard) {
+  ConcurrentOpenAddressingHashTable<int, int, Hash<int>> table(128);
+  ASSERT_EQ(table.shard_count(), 128);
+
+  std::set<ctrl_t> tags;
+  size_t in_shard = 0;
+  for (int key = 0; key < 100000; ++key)
+    if (table.shard_index(key) == 5) {
+      ++in_shard;
+      tags.insert(ctrl_tag(Hash<int>()(key)));
+    }
+  EXPECT_GT(in_shard, 100000u / 128 / 2);
+  // All 128 tags show up among the ~800 keys of a uniform shard.
+  EXPECT_GT(tags.size(), 120u);
+}
+
+TEST(ConcurrentHashTableTest, ParallelInsertEraseAndUpdate) {
+  ConcurrentOpenAddressingHashTable<int, int, Hash<int>> table(8);
+  const int THREADS = 4;
+  const int PER_THREAD = 20000;
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < THREADS; ++t)
+    workers.emplace_back([&table, t] {
+      for (int i = 0; i < PER_THREAD; ++i) {
+        int key = t * PER_THREAD + i;
+        table.insert(key, key);
+        table.update(-1, [](int &count) { ++count; });
+        if (i % 2 == 0)
+          table.erase(key);
+      }
+    });
+  for (auto &worker : workers)
+    worker.join();
+
+  EXPECT_EQ(table.size(), THREADS * PER_THREAD / 2 + 1);
+  EXPECT_EQ(table.find(-1), THREADS * PER_THREAD);
+  for (int key = 0; key < THREADS * PER_THREAD; ++key)
+    EXPECT_EQ(table.contains(key), key % 2 == 1);
+}
+
+TEST(ConcurrentHashTableTest, SharedTelemetry) {
+  ConcurrentOpenAddressingHashTable<int, int, Hash<int>> table(8);
+  HashTableTelemetry telemetry(1);
+  table.set_telemetry(&telemetry);
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 4; ++t)
+    workers.emplace_back([&table, t] {
+      for (int i = 0; i < 1000; ++i)
+        table.insert(t * 1000 + i, i);
+    });
+  for (auto &worker : workers)
+    worker.join();
+
+  TelemetrySnapshot snapshot = table.telemetry_snapshot();
+  EXPECT_EQ(snapshot.insert.samples, 4000u);
+  EXPECT_GT(snapshot.rehashes, 0u);
+  EXPECT_EQ(snapshot.size, 4000u);
+  EXPECT_GT(snapshot.capacity, 4000u);
+  EXPECT_GT(snapshot.load_factor, 0.0f);
+}
@@ -0,0 +1,93 @@
+#include "open_addressing_hash_table.h"
+#include <cstdio>
+#include <gtest/gtest.h>
+
+TEST(FrozenHashTableTest, FreezeIntTable) {
+  OpenAddressingHashTable<int, int, Hash<int>> table;
+  for (int i = 0; i < 100000; ++i)
+    table.insert(i * 7, i);
+  for (int i = 0; i < 100000; i += 4)
+    table.erase(i * 7);
+
+  FrozenHashTable<int, int, Hash<int>> frozen = table.freeze();
+  EXPECT_EQ(frozen.size(), table.size());
+  EXPECT_EQ(frozen.bucket_count(),
+            (frozen.size() + frozen.BUCKET_SIZE - 1) / frozen.BUCKET_SIZE);
+  for (int i = 0; i < 100000; ++i) {
+    const int *value = frozen.find(i * 7);
+    if (i % 4 == 0) {
+      ASSERT_EQ(value, nullptr) << i;
+    } else {
+      ASSERT_NE(value, nullptr) << i;
+      ASSERT_EQ(*value, i);
+    }
+    ASSERT_FALSE(frozen.contains(i * 7 + 1));
+  }
+  EXPECT_THROW(frozen.at(1), std::out_of_range);
+
+  size_t visited = 0;
+  for (const auto &entry : frozen)
+    visited += table.at(entry.key) == entry.value;
+  EXPECT_EQ(visited, frozen.size());
+  EXPECT_LT(frozen.memory_bytes(),
+            table.bucket_count() * sizeof(Entry<int, int>));
+}
+
+TEST(FrozenHashTableTest, StringKeysAndDuplicates) {
+  std::vector<std::pair<std::string, int>> items;
+  for (int i = 0; i < 5000; ++i)
+    items.emplace_back("key_" + std::to_string(i), i);
+  items.emplace_back("key_17", -1);
+  items.emplace_back("key_4999", -1);
+
+  FrozenHashTable<std::string, int, Hash<std::string>> frozen(items);
+  EXPECT_EQ(frozen.size(), 5000u);
+  for (int i = 0; i < 5000; ++i)
+    ASSERT_EQ(frozen.at("key_" + std::to_string(i)), i);
+  EXPECT_FALSE(frozen.contains("key_5000"));
+
+  FrozenHashTable<std::string, int, Hash<std::string>> empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_FALSE(empty.contains("key_0"));
+  FrozenHashTable<std::string, int, Hash<std::string>> one({{"only", 1}});
+  EXPECT_EQ(one.at("only"), 1);
+  EXPECT_FALSE(one.contains("other"));
+
+  struct ConstantHash {
+    size_t operator()(int) const { return 42; }
+  };
+  std::vector<std::pair<int, int>> colliding = {{1, 1}, {1, 2}};
+  FrozenHashTable<int, int, ConstantHash> same_key(colliding);
+  EXPECT_EQ(same_key.at(1), 1);
+  colliding.emplace_back(2, 3);
+  EXPECT_THROW((FrozenHashTable<int, int, ConstantHash>(colliding)),
+               std::invalid_argument);
+}
+
+TEST(FrozenHashTableTest, SaveAndLoad) {
+  OpenAddressingHashTable<uint64_t, double, std::hash<uint64_t>> table;
+  for (uint64_t i = 0; i < 20000; ++i)
+    table.insert(i, i * 0.5);
+  // Equal to key 5 in the low 32 bits.
+  const uint64_t high = (uint64_t(1) << 32) | 5;
+  table.insert(high, -1.0);
+  auto frozen = table.freeze();
+
+  const std::string path = testing::TempDir() + "frozen_table.bin";
+  frozen.save(path);
+  auto loaded =
+      FrozenHashTable<uint64_t, double, std::hash<uint64_t>>::load(path);
+  EXPECT_EQ(loaded.size(), frozen.size());
+  for (uint64_t i = 0; i < 20000; ++i)
+    ASSERT_EQ(loaded.at(i), i * 0.5);
+  EXPECT_EQ(loaded.at(high), -1.0);
+  EXPECT_FALSE(loaded.contains(20000));
+
+  EXPECT_THROW(
+      (FrozenHashTable<uint64_t, float, std::hash<uint64_t>>::load(path)),
+      std::runtime_error);
+  EXPECT_THROW((FrozenHashTable<uint64_t, double, std::hash<uint64_t>>::load(
+                   path + ".missing")),
+               std::runtime_error);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,141 @@
+#include "incremental_hash_table.h"
+#include <gtest/gtest.h>
+
+TEST(IncrementalHashTableTest, InsertFindAcrossMigration) {
+  IncrementalHashTable<int, int, Hash<int>> table;
+  bool saw_migration = false;
+
+  for (int i = 0; i < 20000; ++i) {
+    EXPECT_TRUE(table.insert(i, i * 2).second);
+    saw_migration |= table.is_rehashing();
+  }
+  EXPECT_TRUE(saw_migration);
+  EXPECT_EQ(table.size(), 20000);
+
+  for (int i = 0; i < 20000; ++i) {
+    auto it = table.find(i);
+    ASSERT_NE(it, table.end());
+    EXPECT_EQ(it->value, i * 2);
+  }
+  EXPECT_EQ(table.find(20000), table.end());
+  EXPECT_FALSE(table.insert(5, 0).second);
+  EXPECT_EQ(table.at(5), 10);
+}
+
+TEST(IncrementalHashTableTest, EraseDuringMigration) {
+  IncrementalHashTable<std::string, int, Hash<std::string>> table;
+  const int N = 5000;
+
+  for (int i = 0; i < N; ++i) {
+    table.insert("key_" + std::to_string(i), i);
+    if (i % 3 == 0) {
+      EXPECT_EQ(table.erase("key_" + std::to_string(i / 3)), 1);
+    }
+  }
+
+  size_t expected = 0;
+  for (int i = 0; i < N; ++i) {
+    bool erased = i <= (N - 1) / 3;
+    EXPECT_EQ(table.contains("key_" + std::to_string(i)), !erased);
+    expected += !erased;
+  }
+  EXPECT_EQ(table.size(), expected);
+}
+
+TEST(IncrementalHashTableTest, IterationCoversBothTables) {
+  IncrementalHashTable<int, int, Hash<int>> table;
+  int i = 0;
+  while (!table.is_rehashing() || table.size() < 100)
+    table[i++] = 1;
+  ASSERT_TRUE(table.is_rehashing());
+
+  size_t visited = 0;
+  long long sum = 0;
+  for (auto &entry : table) {
+    ++visited;
+    sum += entry.key;
+  }
+  EXPECT_EQ(visited, table.size());
+  EXPECT_EQ(sum, static_cast<long long>(i) * (i - 1) / 2);
+
+  table.finish_rehash();
+  EXPECT_FALSE(table.is_rehashing());
+  EXPECT_EQ(table.size(), static_cast<size_t>(i));
+}
+
+// Value that counts every slot constructed or moved, i.e. the work a call
+// does on the table's storage.
+struct CountedValue {
+  static inline size_t work = 0;
+  int value = 0;
+  CountedValue() { ++work; }
+  CountedValue(int value) : value(value) { ++work; }
+  CountedValue(const CountedValue &other) : value(other.value) { ++work; }
+  CountedValue(CountedValue &&other) noexcept : value(other.value) { ++work; }
+  CountedValue &operator=(const CountedValue &other) {
+    value = other.value;
+    ++work;
+    return *this;
+  }
+  CountedValue &operator=(CountedValue &&other) noexcept {
+    value = other.value;
+    ++work;
+    return *this;
+  }
+};
+
+TEST(IncrementalHashTableTest, BoundedWorkPerInsertDuringCleanup) {
+  using Table = IncrementalHashTable<int, CountedValue, Hash<int>>;
+  const size_t bound = 2 * Table::PREPARE_STEP + 2 * Table::MIGRATION_STEP + 8;
+  Table table;
+  size_t worst = 0;
+  auto measure = [&](auto &&call) {
+    size_t before = CountedValue::work;
+    call();
+    worst = std::max(worst, CountedValue::work - before);
+  };
+  int next = 0;
+  auto insert_next = [&] {
+    int key = next++;
+    table.insert(key, key + 1);
+  };
+
+  // Fill to just under max_load_factor(), then churn at that size so the
+  // tombstones, not the load, trigger the migrations.
+  while (table.bucket_count() < 4096 ||
+         static_cast<float>(table.size() + 1) / table.bucket_count() <=
+             table.max_load_factor() - 0.01f)
+    measure(insert_next);
+  const size_t live = table.size();
+
+  bool saw_cleanup = false;
+  size_t capacity = table.bucket_count();
+  for (int round = 0; round < 20 * static_cast<int>(live); ++round) {
+    bool was_rehashing = table.is_rehashing();
+    measure([&] { table.erase(next - static_cast<int>(live)); });
+    measure(insert_next);
+    if (table.bucket_count() != capacity) {
+      // Only a migration may change the capacity, never a synchronous grow.
+      EXPECT_TRUE(table.is_rehashing() && !was_rehashing);
+      capacity = table.bucket_count();
+    } else if (table.is_rehashing() && !was_rehashing) {
+      saw_cleanup = true;
+    }
+    EXPECT_LE(static_cast<float>(table.size()) / table.bucket_count(),
+              table.max_load_factor());
+  }
+  EXPECT_TRUE(saw_cleanup);
+  EXPECT_EQ(table.size(), live);
+
+  // Lowering the factor does not rehash on the spot either.
+  measure([&] { table.max_load_factor(0.3f); });
+  for (int i = 0; i < static_cast<int>(live); ++i)
+    measure(insert_next);
+  EXPECT_LE(worst, bound);
+
+  for (int i = next - 2 * static_cast<int>(live); i < next; ++i) {
+    auto it = table.find(i);
+    ASSERT_NE(it, table.end());
+    EXPECT_EQ(it->value.value, i + 1);
+  }
+}
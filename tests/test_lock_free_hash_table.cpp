@@ -0,0 +1,85 @@
+#include "lock_free_hash_table.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+TEST(LockFreeHashTableTest, BasicOperations) {
+  LockFreeHashTable<int, int, Hash<int>> table;
+
+  EXPECT_TRUE(table.insert(1, 10));
+  EXPECT_FALSE(table.insert(1, 11));
+  EXPECT_EQ(table.find(1), 10);
+  EXPECT_EQ(table.fetch_add(1, 5), 10);
+  EXPECT_EQ(table.find(1), 15);
+  EXPECT_EQ(table.fetch_add(2, 3), 0);
+  table.insert_or_assign(2, 7);
+  EXPECT_EQ(table.find(2), 7);
+  EXPECT_EQ(table.find(3), std::nullopt);
+  EXPECT_EQ(table.size(), 2);
+
+  // Grow through several migrations from the smallest table.
+  for (int key = 100; key < 10100; ++key)
+    table.insert(key, key);
+  EXPECT_GT(table.bucket_count(), 10000);
+  EXPECT_EQ(table.size(), 10002);
+  for (int key = 100; key < 10100; ++key)
+    ASSERT_EQ(table.find(key), key);
+  EXPECT_EQ(table.find(1), 15);
+}
+
+TEST(LockFreeHashTableTest, ParallelCountersSurviveMigration) {
+  LockFreeHashTable<int64_t, int64_t> table(16);
+  const int THREADS = 4;
+  const int KEYS = 20000;
+  const int ROUNDS = 3;
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < THREADS; ++t)
+    workers.emplace_back([&table, t] {
+      for (int round = 0; round < ROUNDS; ++round)
+        for (int i = 0; i < KEYS; ++i) {
+          int64_t key = (i * 7 + t * 13) % KEYS;
+          table.fetch_add(key, 1);
+          if (i % 64 == 0)
+            table.find((key + 1) % KEYS);
+        }
+    });
+  for (auto &worker : workers)
+    worker.join();
+
+  EXPECT_EQ(table.size(), KEYS);
+  for (int64_t key = 0; key < KEYS; ++key)
+    ASSERT_EQ(table.find(key), THREADS * ROUNDS);
+}
+
+TEST(LockFreeHashTableTest, FindDuringMigration) {
+  const int64_t OLD_KEYS = 200;
+  const int64_t NEW_KEYS = 100000;
+  std::atomic<size_t> lookups{0};
+  std::atomic<size_t> misses{0};
+
+  for (int run = 0; run < 5; ++run) {
+    LockFreeHashTable<int64_t, int64_t> table(16);
+    for (int64_t key = 0; key < OLD_KEYS; ++key)
+      table.insert(key, key + 1);
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t)
+      readers.emplace_back([&] {
+        while (!done.load(std::memory_order_acquire))
+          for (int64_t key = 0; key < OLD_KEYS; ++key) {
+            lookups.fetch_add(1, std::memory_order_relaxed);
+            if (table.find(key) != key + 1)
+              misses.fetch_add(1, std::memory_order_relaxed);
+          }
+      });
+    // Each insert helps migrate, so the readers keep meeting MOVED slots.
+    for (int64_t key = OLD_KEYS; key < OLD_KEYS + NEW_KEYS; ++key)
+      table.insert(key, key + 1);
+    done.store(true, std::memory_order_release);
+    for (auto &reader : readers)
+      reader.join();
+  }
+  EXPECT_GT(lookups.load(), 0u);
+  EXPECT_EQ(misses.load(), 0u);
+}
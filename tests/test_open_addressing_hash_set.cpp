@@ -0,0 +1,88 @@
+#include "open_addressing_hash_set.h"
+#include <gtest/gtest.h>
+#include <set>
+
+static_assert(sizeof(Entry<uint64_t, NoValue>) == sizeof(uint64_t));
+static_assert(sizeof(Entry<int, NoValue>) < sizeof(Entry<int, bool>));
+
+TEST(OpenAddressingHashSetTest, BasicOperations) {
+  OpenAddressingHashSet<std::string, Hash<std::string>> set;
+  EXPECT_TRUE(set.empty());
+  EXPECT_TRUE(set.insert("one").second);
+  EXPECT_TRUE(set.insert("two").second);
+  EXPECT_FALSE(set.insert("one").second);
+  EXPECT_EQ(set.size(), 2u);
+  EXPECT_TRUE(set.contains("one"));
+  EXPECT_EQ(set.count("three"), 0u);
+  EXPECT_EQ(*set.find("two"), "two");
+  EXPECT_EQ(set.find("three"), set.end());
+
+  EXPECT_EQ(set.erase("one"), 1u);
+  EXPECT_EQ(set.erase("one"), 0u);
+  EXPECT_FALSE(set.contains("one"));
+  set.erase(set.find("two"));
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(set.begin(), set.end());
+}
+
+TEST(OpenAddressingHashSetTest, GrowEraseAndIterate) {
+  OpenAddressingHashSet<uint64_t> set;
+  std::set<uint64_t> reference;
+  for (uint64_t i = 0; i < 50000; ++i) {
+    set.insert(i * 7919);
+    reference.insert(i * 7919);
+  }
+  for (uint64_t i = 0; i < 50000; i += 3) {
+    set.erase(i * 7919);
+    reference.erase(i * 7919);
+  }
+  EXPECT_EQ(set.size(), reference.size());
+  std::set<uint64_t> seen(set.begin(), set.end());
+  EXPECT_EQ(seen, reference);
+
+  set.rehash(set.bucket_count() * 2);
+  for (uint64_t key : reference)
+    ASSERT_TRUE(set.contains(key));
+
+  std::vector<uint64_t> keys = {7919, 3 * 7919, 1};
+  bool found[3];
+  set.contains_batch(keys.data(), keys.size(), found);
+  EXPECT_TRUE(found[0]);
+  EXPECT_FALSE(found[1]);
+  EXPECT_FALSE(found[2]);
+
+  set.clear();
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(set.begin(), set.end());
+}
+
+TEST(OpenAddressingHashSetTest, MergeAndIntersect) {
+  OpenAddressingHashSet<int, Hash<int>> evens, threes;
+  for (int i = 0; i < 3000; i += 2)
+    evens.insert(i);
+  for (int i = 0; i < 300; i += 3)
+    threes.insert(i);
+
+  OpenAddressingHashSet<int, Hash<int>> both = evens;
+  both.intersect(threes);
+  OpenAddressingHashSet<int, Hash<int>> small_first = threes;
+  small_first.intersect(evens);
+  EXPECT_EQ(both.size(), 50u);
+  EXPECT_EQ(both, small_first);
+  for (int key : both)
+    EXPECT_EQ(key % 6, 0);
+
+  OpenAddressingHashSet<int, Hash<int>> all = threes;
+  all.merge(evens);
+  EXPECT_EQ(all.size(), 1500u + 100u - 50u);
+  OpenAddressingHashSet<int, Hash<int>> moved = threes;
+  moved.merge(OpenAddressingHashSet<int, Hash<int>>(evens));
+  EXPECT_EQ(moved, all);
+  EXPECT_NE(moved, evens);
+
+  OpenAddressingHashSet<int, Hash<int>> empty;
+  all.intersect(empty);
+  EXPECT_TRUE(all.empty());
+  all.merge(all);
+  EXPECT_TRUE(all.empty());
+}
@@ -1,5 +1,14 @@
+#include "accelerated_hash.h"
+#include "allocators.h"
+#include "cuckoo_hash_table.h"
 #include "open_addressing_hash_table.h"
+#include "robin_hood_hash_table.h"
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
 
 TEST(OpenAddressingHashTableTest, InsertAndFind) {
   OpenAddressingHashTable<int, std::string> table;
@@ -166,8 +175,18 @@ TEST(OpenAddressingHashTableTest, LowStressInsertErase) {
       EXPECT_TRUE(table.contains(i));
 }
 
-TEST(OpenAddressingHashTableTest, HighStressInsertErase) {
-  OpenAddressingHashTable<int, int> table;
+template <typename Table>
+class InsertEraseStressTest : public ::testing::Test {};
+
+using StressTables =
+    ::testing::Types<OpenAddressingHashTable<int, int>,
+                     RobinHoodHashTable<int, int, Hash<int>>,
+                     CuckooHashTable<int, int, Hash<int>>,
+                     CuckooHashTable<int, int, Hash<int>, 8>>;
+TYPED_TEST_SUITE(InsertEraseStressTest, StressTables);
+
+TYPED_TEST(InsertEraseStressTest, HighStressInsertErase) {
+  TypeParam table;
   const int N = 10000;
 
   for (int i = 0; i < N; ++i)
@@ -187,6 +206,64 @@ TEST(OpenAddressingHashTableTest, HighStressInsertErase) {
       EXPECT_TRUE(table.contains(i));
 }
 
+TYPED_TEST(InsertEraseStressTest, ChurnKeepsContents) {
+  TypeParam table;
+  const int N = 2000;
+
+  for (int round = 0; round < 20; ++round) {
+    for (int i = 0; i < N; ++i)
+      table.insert(round * N + i, i);
+    for (int i = 0; i < N; ++i)
+      if (i % 4 != 0) {
+        EXPECT_EQ(table.erase(round * N + i), 1);
+      }
+  }
+
+  EXPECT_EQ(table.size(), 20 * N / 4);
+  for (int round = 0; round < 20; ++round)
+    for (int i = 0; i < N; ++i) {
+      auto it = table.find(round * N + i);
+      if (i % 4 == 0) {
+        ASSERT_NE(it, table.end());
+        EXPECT_EQ(it->value, i);
+      } else {
+        EXPECT_EQ(it, table.end());
+      }
+    }
+}
+
+TYPED_TEST(InsertEraseStressTest, InsertionsNeverOverwrite) {
+  TypeParam table;
+  const int N = 1000;
+
+  for (int i = 0; i < N; ++i) {
+    auto inserted = table.insert(i, i);
+    EXPECT_TRUE(inserted.second);
+    EXPECT_EQ(inserted.first->key, i);
+    EXPECT_EQ(inserted.first->value, i);
+  }
+  for (int i = 0; i < N; ++i) {
+    auto existing = table.insert(i, -1);
+    EXPECT_FALSE(existing.second);
+    EXPECT_EQ(existing.first, table.find(i));
+    EXPECT_FALSE(table.try_emplace(i, -1).second);
+    EXPECT_FALSE(table.emplace(i, -1).second);
+    EXPECT_EQ(table.at(i), i);
+  }
+
+  EXPECT_TRUE(table.try_emplace(N, 7).second);
+  EXPECT_TRUE(table.emplace(N + 1, 8).second);
+  auto assigned = table.insert_or_assign(0, -5);
+  EXPECT_FALSE(assigned.second);
+  EXPECT_EQ(assigned.first->value, -5);
+  EXPECT_TRUE(table.insert_or_assign(N + 2, 9).second);
+
+  EXPECT_EQ(table.size(), N + 3);
+  EXPECT_EQ(table.at(0), -5);
+  EXPECT_EQ(table.at(N), 7);
+  EXPECT_EQ(table.at(N + 1), 8);
+  EXPECT_EQ(table.at(N + 2), 9);
+}
 
 TEST(OpenAddressingHashTableTest, SwapWorksCorrectly) {
   OpenAddressingHashTable<int, std::string> t1{{1, "A"}, {2, "B"}};
@@ -214,3 +291,848 @@ TEST(OpenAddressingHashTableTest, IteratorTraversal) {
   EXPECT_EQ(keys.size(), 3);
   EXPECT_NE(std::find(keys.begin(), keys.end(), 1), keys.end());
 }
+
+TEST(OpenAddressingHashTableTest, LinearProbingGroupScanAcrossWrap) {
+  struct CornerHash {
+    size_t operator()(int key) const { return key < 100 ? 60 : key; }
+  };
+
+  OpenAddressingHashTable<int, int, CornerHash, LinearHashing<int>> table;
+  table.rehash(64);
+  for (int i = 0; i < 20; ++i)
+    table.insert(i, i + 1);
+
+  for (int i = 0; i < 20; ++i)
+    EXPECT_EQ(table.at(i), i + 1);
+  EXPECT_FALSE(table.contains(20));
+
+  for (int i = 0; i < 20; i += 3)
+    table.erase(i);
+  for (int i = 0; i < 20; ++i)
+    EXPECT_EQ(table.contains(i), i % 3 != 0);
+}
+
+TEST(OpenAddressingHashTableTest, StringKeysAllProbingPolicies) {
+  OpenAddressingHashTable<std::string, int, Hash<std::string>,
+                          LinearHashing<std::string>>
+      linear;
+  OpenAddressingHashTable<std::string, int, Hash<std::string>,
+                          QuadraticHashing<std::string>>
+      quadratic;
+  OpenAddressingHashTable<std::string, int, Hash<std::string>,
+                          DoubleHashing<std::string>>
+      doubled;
+
+  for (int i = 0; i < 3000; ++i) {
+    std::string key = "key_" + std::to_string(i);
+    linear.insert(key, i);
+    quadratic.insert(key, i);
+    doubled.insert(key, i);
+  }
+  for (int i = 0; i < 3000; i += 2) {
+    std::string key = "key_" + std::to_string(i);
+    linear.erase(key);
+    quadratic.erase(key);
+    doubled.erase(key);
+  }
+  for (int i = 0; i < 3000; ++i) {
+    std::string key = "key_" + std::to_string(i);
+    EXPECT_EQ(linear.contains(key), i % 2 == 1);
+    EXPECT_EQ(quadratic.contains(key), i % 2 == 1);
+    EXPECT_EQ(doubled.contains(key), i % 2 == 1);
+  }
+}
+
+TEST(RobinHoodHashTableTest, EraseLeavesNoTombstones) {
+  RobinHoodHashTable<int, int, Hash<int>> table;
+  for (int i = 0; i < 5000; ++i)
+    table.insert(i, i);
+  for (int i = 0; i < 5000; i += 3)
+    table.erase(i);
+
+  for (auto &entry : table.get_container())
+    EXPECT_NE(entry.state, EntryState::DELETED);
+  for (int i = 0; i < 5000; ++i)
+    EXPECT_EQ(table.contains(i), i % 3 != 0);
+}
+
+TEST(RobinHoodHashTableTest, CollidingKeysAndOperators) {
+  struct BadHash {
+    size_t operator()(int) const { return 7; }
+  };
+
+  RobinHoodHashTable<int, std::string, BadHash> table;
+  for (int i = 0; i < 40; ++i)
+    table[i] = std::to_string(i);
+  EXPECT_EQ(table.max_probe_length(), 39);
+
+  table.erase(0);
+  EXPECT_EQ(table.max_probe_length(), 38);
+  EXPECT_THROW(table.at(0), std::out_of_range);
+  for (int i = 1; i < 40; ++i)
+    EXPECT_EQ(table.at(i), std::to_string(i));
+
+  RobinHoodHashTable<int, std::string, BadHash> copy = table;
+  EXPECT_TRUE(copy == table);
+  copy[1] = "changed";
+  EXPECT_TRUE(copy != table);
+}
+
+TEST(RobinHoodHashTableTest, TransparentLookup) {
+  RobinHoodHashTable<std::string, int, Hash<std::string>> table;
+  for (int i = 0; i < 100; ++i)
+    table.try_emplace("key_" + std::to_string(i), i);
+
+  std::string buffer = "key_42 trailing bytes";
+  std::string_view key(buffer.data(), 6);
+  EXPECT_TRUE(table.contains(key));
+  EXPECT_EQ(table.find(key)->value, 42);
+  EXPECT_EQ(table.at(key), 42);
+  EXPECT_FALSE(table.insert(key, -1).second);
+  table[std::string_view("fresh")] = 5;
+  EXPECT_EQ(table.at("fresh"), 5);
+  EXPECT_EQ(table.erase(key), 1);
+  EXPECT_FALSE(table.contains(key));
+  EXPECT_THROW(table.at(key), std::out_of_range);
+  EXPECT_EQ(table.size(), 100);
+}
+
+TEST(CuckooHashTableTest, FillsToMaxLoadWithoutGrowing) {
+  using Table = CuckooHashTable<int, int, Hash<int>>;
+  Table table;
+  table.reserve(50000);
+  const size_t capacity = table.bucket_count();
+  const int n = static_cast<int>(capacity * Table::MAX_LOAD);
+
+  // Strided keys: Hash<int> leaves every one of them with low bits zero.
+  for (int i = 0; i < n; ++i)
+    EXPECT_TRUE(table.insert(i * 1024, i).second);
+  EXPECT_EQ(table.bucket_count(), capacity);
+  EXPECT_FALSE(table.insert(0, -1).second);
+
+  for (int i = 0; i < n; ++i)
+    ASSERT_EQ(table.at(i * 1024), i);
+  for (int i = 0; i < n; i += 2)
+    EXPECT_EQ(table.erase(i * 1024), 1);
+  EXPECT_EQ(table.size(), static_cast<size_t>(n / 2));
+  for (int i = 0; i < n; ++i)
+    EXPECT_EQ(table.contains(i * 1024), i % 2 == 1);
+
+  size_t visited = 0;
+  for (auto &entry : table) {
+    EXPECT_EQ(entry.key, entry.value * 1024);
+    ++visited;
+  }
+  EXPECT_EQ(visited, table.size());
+}
+
+TEST(CuckooHashTableTest, KeysSharingAHashAreBounded) {
+  struct BadHash {
+    size_t operator()(int) const { return 7; }
+  };
+
+  // Two buckets of four slots hold every key with this hash; a ninth has
+  // nowhere to go at any size.
+  CuckooHashTable<int, std::string, BadHash> table;
+  for (int i = 0; i < 8; ++i)
+    table[i] = std::to_string(i);
+  EXPECT_THROW(table.insert(8, "8"), std::length_error);
+  EXPECT_EQ(table.size(), 8);
+  EXPECT_FALSE(table.contains(8));
+  for (int i = 0; i < 8; ++i)
+    EXPECT_EQ(table.at(i), std::to_string(i));
+  EXPECT_THROW(table.at(8), std::out_of_range);
+
+  CuckooHashTable<int, std::string, BadHash> copy = table;
+  EXPECT_TRUE(copy == table);
+  copy[1] = "changed";
+  EXPECT_TRUE(copy != table);
+
+  CuckooHashTable<int, std::string, BadHash> moved = std::move(copy);
+  EXPECT_EQ(moved.at(1), "changed");
+  EXPECT_TRUE(copy.empty());
+  copy = moved;
+  EXPECT_TRUE(copy == moved);
+}
+
+TEST(CuckooHashTableTest, StringKeysAndRehash) {
+  CuckooHashTable<std::string, int, Hash<std::string>, 8> table{{"a", 1},
+                                                                {"b", 2}};
+  for (int i = 0; i < 3000; ++i)
+    table["key_" + std::to_string(i)] = i;
+  EXPECT_LE(table.load_factor(), table.max_load_factor());
+
+  table.rehash(1 << 16);
+  EXPECT_GE(table.bucket_count(), size_t(1) << 16);
+  table.rehash(0);
+  EXPECT_LT(table.bucket_count(), size_t(1) << 16);
+  EXPECT_EQ(table.size(), 3002);
+  EXPECT_EQ(table.at("b"), 2);
+  for (int i = 0; i < 3000; ++i)
+    EXPECT_EQ(table.at("key_" + std::to_string(i)), i);
+
+  table.clear();
+  EXPECT_TRUE(table.empty());
+  EXPECT_EQ(table.find("a"), table.end());
+}
+
+TEST(CuckooHashTableTest, EmplaceAndTransparentLookup) {
+  CuckooHashTable<std::string, std::string, Hash<std::string>> table;
+  auto first = table.try_emplace("key", 3, 'x');
+  EXPECT_TRUE(first.second);
+  EXPECT_EQ(first.first->value, "xxx");
+  auto second = table.emplace("key", "other");
+  EXPECT_FALSE(second.second);
+  EXPECT_EQ(second.first, first.first);
+  EXPECT_EQ(table.at("key"), "xxx");
+
+  auto assigned = table.insert_or_assign(std::string("key"), "yy");
+  EXPECT_FALSE(assigned.second);
+  EXPECT_EQ(assigned.first->value, "yy");
+  EXPECT_TRUE(table.insert_or_assign("new", "z").second);
+
+  std::string buffer = "key trailing bytes";
+  std::string_view key(buffer.data(), 3);
+  EXPECT_TRUE(table.contains(key));
+  EXPECT_EQ(table.find(key)->value, "yy");
+  EXPECT_FALSE(table.insert(key, "ignored").second);
+  table[std::string_view("fresh")] = "f";
+  EXPECT_EQ(table.size(), 3);
+  EXPECT_EQ(table.erase(key), 1);
+  EXPECT_FALSE(table.contains(key));
+  EXPECT_THROW(table.at(key), std::out_of_range);
+}
+
+TEST(OpenAddressingHashTableTest, InsertDoesNotDuplicateKeys) {
+  OpenAddressingHashTable<int, std::string> table;
+
+  auto first = table.insert(1, "One");
+  EXPECT_TRUE(first.second);
+  auto second = table.insert(1, "Uno");
+  EXPECT_FALSE(second.second);
+  EXPECT_EQ(second.first, first.first);
+  EXPECT_EQ(table.size(), 1);
+  EXPECT_EQ(table.at(1), "One");
+
+  auto assigned = table.insert_or_assign(1, "Uno");
+  EXPECT_FALSE(assigned.second);
+  EXPECT_EQ(table.at(1), "Uno");
+  EXPECT_TRUE(table.insert_or_assign(2, "Dos").second);
+  EXPECT_EQ(table.size(), 2);
+}
+
+TEST(OpenAddressingHashTableTest, EmplaceMoveOnlyValues) {
+  OpenAddressingHashTable<std::string, std::unique_ptr<int>, Hash<std::string>>
+      table;
+
+  auto result = table.try_emplace("answer", std::make_unique<int>(42));
+  ASSERT_TRUE(result.second);
+  EXPECT_EQ(*result.first->value, 42);
+
+  auto value = std::make_unique<int>(7);
+  EXPECT_FALSE(table.try_emplace("answer", std::move(value)).second);
+  ASSERT_NE(value, nullptr);
+
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_TRUE(table.emplace("key_" + std::to_string(i), new int(i)).second);
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(*table.at("key_" + std::to_string(i)), i);
+
+  table.insert_or_assign("answer", std::make_unique<int>(43));
+  EXPECT_EQ(*table.at("answer"), 43);
+  EXPECT_EQ(table.size(), 1001);
+}
+
+struct CountingStringHash : Hash<std::string> {
+  static inline size_t calls = 0;
+  template <typename Q> size_t operator()(const Q &key) const {
+    ++calls;
+    return Hash<std::string>::operator()(key);
+  }
+};
+
+TEST(OpenAddressingHashTableTest, StoredHashSkipsRehashing) {
+  OpenAddressingHashTable<std::string, int, StoreHash<CountingStringHash>>
+      stored;
+  OpenAddressingHashTable<std::string, int, CountingStringHash> plain;
+
+  CountingStringHash::calls = 0;
+  for (int i = 0; i < 1000; ++i)
+    stored.insert("key_" + std::to_string(i), i);
+  EXPECT_EQ(CountingStringHash::calls, 1000);
+
+  CountingStringHash::calls = 0;
+  for (int i = 0; i < 1000; ++i)
+    plain.insert("key_" + std::to_string(i), i);
+  EXPECT_GT(CountingStringHash::calls, 1000);
+
+  for (int i = 0; i < 1000; i += 2)
+    stored.erase("key_" + std::to_string(i));
+  stored.rehash(4096);
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(stored.contains(std::string_view("key_" + std::to_string(i))),
+              i % 2 == 1);
+}
+
+TEST(OpenAddressingHashTableTest, BatchLookupMatchesFind) {
+  OpenAddressingHashTable<int, int, Hash<int>> linear;
+  OpenAddressingHashTable<int, int, Hash<int>, DoubleHashing<int>> doubled;
+  for (int i = 0; i < 1000; i += 2) {
+    linear.insert(i, i * 3);
+    doubled.insert(i, i * 3);
+  }
+
+  // Not a multiple of the internal block size.
+  std::vector<int> keys;
+  for (int i = 0; i < 1000; i += 3)
+    keys.push_back(i);
+
+  std::vector<OpenAddressingHashTable<int, int, Hash<int>>::iterator> found(
+      keys.size());
+  std::unique_ptr<bool[]> present(new bool[keys.size()]);
+  linear.find_batch(keys.data(), keys.size(), found.data());
+  doubled.contains_batch(keys.data(), keys.size(), present.get());
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(found[i], linear.find(keys[i]));
+    if (keys[i] % 2 == 0) {
+      EXPECT_EQ(found[i]->value, keys[i] * 3);
+    }
+    EXPECT_EQ(present[i], keys[i] % 2 == 0);
+  }
+}
+
+TEST(OpenAddressingHashTableTest, ArenaAllocatedTable) {
+  Arena arena(1 << 12);
+  using Table =
+      OpenAddressingHashTable<std::string, int, Hash<std::string>,
+                              LinearHashing<std::string>,
+                              ArenaAllocator<Entry<std::string, int>>>;
+  Table table{ArenaAllocator<Entry<std::string, int>>(arena)};
+  for (int i = 0; i < 500; ++i)
+    table.insert("key_" + std::to_string(i), i);
+  EXPECT_GT(arena.bytes_allocated(),
+            table.bucket_count() * sizeof(Entry<std::string, int>));
+
+  // Copies and moves keep allocating from the same arena.
+  Table copy(table);
+  EXPECT_TRUE(copy.get_allocator() == table.get_allocator());
+  Table moved(std::move(copy));
+  for (int i = 0; i < 500; ++i)
+    EXPECT_EQ(moved.at("key_" + std::to_string(i)), i);
+  EXPECT_TRUE(moved == table);
+}
+
+#ifdef __linux__
+TEST(OpenAddressingHashTableTest, HugePageAllocatedTable) {
+  OpenAddressingHashTable<int, int, Hash<int>, LinearHashing<int>,
+                          HugePageAllocator<Entry<int, int>>>
+      table;
+  for (int i = 0; i < 200000; ++i)
+    table.insert(i, -i);
+  EXPECT_GE(table.bucket_count() * sizeof(Entry<int, int>),
+            HugePageAllocator<char>::MIN_BYTES);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(table.data.data()) %
+                HugePageAllocator<char>::HUGE_PAGE_SIZE,
+            0u);
+  for (int i = 0; i < 200000; i += 7)
+    ASSERT_EQ(table.at(i), -i);
+  for (int i = 0; i < 200000; i += 2)
+    table.erase(i);
+  EXPECT_EQ(table.size(), 100000);
+}
+#endif // __linux__
+
+TEST(OpenAddressingHashTableTest, ReserveAndBulkLoadDoNotRegrow) {
+  std::vector<std::pair<int, int>> pairs;
+  for (int i = 0; i < 10000; ++i)
+    pairs.emplace_back(i, i * 2);
+  pairs.emplace_back(5, -1);
+
+  OpenAddressingHashTable<int, int, Hash<int>> reserved;
+  reserved.reserve(10000);
+  size_t capacity = reserved.bucket_count();
+  const Entry<int, int> *slots = reserved.data.data();
+  for (int i = 0; i < 10000; ++i)
+    reserved.insert(i, i * 2);
+  EXPECT_EQ(reserved.bucket_count(), capacity);
+  EXPECT_EQ(reserved.data.data(), slots);
+  reserved.reserve(10);
+  EXPECT_EQ(reserved.bucket_count(), capacity);
+
+  OpenAddressingHashTable<int, int, Hash<int>> hinted(10000);
+  EXPECT_EQ(hinted.bucket_count(), capacity);
+
+  OpenAddressingHashTable<int, int, Hash<int>> ranged(pairs.begin(),
+                                                      pairs.end());
+  EXPECT_EQ(ranged.bucket_count(), capacity);
+  EXPECT_EQ(ranged.size(), 10000);
+  EXPECT_EQ(ranged.at(5), 10);
+  EXPECT_TRUE(ranged == reserved);
+
+  OpenAddressingHashTable<int, int, Hash<int>> bulk;
+  bulk.bulk_insert(pairs.begin(), pairs.end() - 1);
+  EXPECT_EQ(bulk.bucket_count(), capacity);
+  EXPECT_TRUE(bulk == reserved);
+}
+
+template <typename Table> void check_parallel_rehash() {
+  Table serial, parallel;
+  for (int i = 0; i < 150000; ++i) {
+    serial.insert(i * 7, i);
+    parallel.insert(i * 7, i);
+  }
+  for (int i = 0; i < 150000; i += 3) {
+    serial.erase(i * 7);
+    parallel.erase(i * 7);
+  }
+
+  size_t capacity = serial.bucket_count() * 2;
+  serial.rehash(capacity);
+  parallel.parallel_rehash(capacity, 4);
+  EXPECT_EQ(parallel.bucket_count(), capacity);
+  EXPECT_EQ(parallel.size(), serial.size());
+  EXPECT_TRUE(parallel == serial);
+  for (int i = 0; i < 150000; ++i)
+    ASSERT_EQ(parallel.contains(i * 7), i % 3 != 0);
+}
+
+TEST(OpenAddressingHashTableTest, ParallelRehashMatchesSerial) {
+  check_parallel_rehash<OpenAddressingHashTable<int, int, Hash<int>>>();
+  check_parallel_rehash<
+      OpenAddressingHashTable<int, int, Hash<int>, QuadraticHashing<int>>>();
+  check_parallel_rehash<
+      OpenAddressingHashTable<int, int, Hash<int>, DoubleHashing<int>>>();
+  check_parallel_rehash<
+      OpenAddressingHashTable<int, int, StoreHash<Hash<int>>>>();
+
+  // Too small to split: takes the serial path.
+  OpenAddressingHashTable<std::string, int, Hash<std::string>> small{
+      {"a", 1}, {"b", 2}};
+  small.parallel_rehash(64, 4);
+  EXPECT_EQ(small.bucket_count(), 64);
+  EXPECT_EQ(small.at("b"), 2);
+}
+
+template <typename Table> void check_parallel_build() {
+  // Every key three times over, each copy with a different value.
+  std::vector<std::pair<int, int>> pairs;
+  for (int copy = 0; copy < 3; ++copy)
+    for (int i = 0; i < 100000; ++i)
+      pairs.emplace_back(i * 7, i + copy);
+
+  Table serial, parallel;
+  for (int i = 0; i < 1000; ++i) {
+    serial.insert(i * 7, -i);
+    parallel.insert(i * 7, -i);
+  }
+  serial.erase(7);
+  parallel.erase(7);
+
+  serial.bulk_insert(pairs.begin(), pairs.end());
+  parallel.parallel_build(pairs.begin(), pairs.end(), 4);
+  EXPECT_EQ(parallel.size(), 100000);
+  EXPECT_EQ(parallel.size(), serial.size());
+  EXPECT_TRUE(parallel == serial);
+  EXPECT_EQ(parallel.at(7), 1);
+  EXPECT_EQ(parallel.at(14), -2);
+  EXPECT_EQ(parallel.at(7000), 1000);
+}
+
+TEST(OpenAddressingHashTableTest, ParallelBuildMatchesBulkInsert) {
+  check_parallel_build<OpenAddressingHashTable<int, int, Hash<int>>>();
+  check_parallel_build<
+      OpenAddressingHashTable<int, int, Hash<int>, QuadraticHashing<int>>>();
+  check_parallel_build<
+      OpenAddressingHashTable<int, int, Hash<int>, DoubleHashing<int>>>();
+  check_parallel_build<
+      OpenAddressingHashTable<int, int, StoreHash<Hash<int>>>>();
+
+  // Too small to split: takes the serial path.
+  std::vector<std::pair<std::string, int>> pairs = {{"a", 1}, {"b", 2}};
+  OpenAddressingHashTable<std::string, int, Hash<std::string>> small;
+  small.parallel_build(pairs.begin(), pairs.end(), 4);
+  EXPECT_EQ(small.size(), 2);
+  EXPECT_EQ(small.at("b"), 2);
+}
+
+TEST(OpenAddressingHashTableTest, SlotRangesAndParallelScans) {
+  OpenAddressingHashTable<int, long long, Hash<int>> table;
+  long long key_sum = 0;
+  for (int i = 0; i < 300000; ++i) {
+    table.insert(i, i);
+    if (i % 5 != 0)
+      key_sum += i;
+  }
+  for (int i = 0; i < 300000; i += 5)
+    table.erase(i);
+
+  auto ranges = table.slot_ranges(7);
+  ASSERT_FALSE(ranges.empty());
+  EXPECT_LE(ranges.size(), 7);
+  EXPECT_EQ(ranges.front().begin, 0);
+  EXPECT_EQ(ranges.back().end, table.bucket_count());
+  size_t visited = 0;
+  for (size_t r = 0; r < ranges.size(); ++r) {
+    EXPECT_EQ(ranges[r].begin % Group::WIDTH, 0);
+    if (r > 0) {
+      EXPECT_EQ(ranges[r].begin, ranges[r - 1].end);
+    }
+    table.for_each(ranges[r], [&](auto &) { ++visited; });
+  }
+  EXPECT_EQ(visited, table.size());
+
+  table.parallel_for_each([](auto &entry) { entry.value *= 2; }, 4);
+  for (int i = 1; i < 300000; i += 7)
+    if (i % 5 != 0) {
+      ASSERT_EQ(table.at(i), 2 * i);
+    }
+
+  auto sum_keys = [&](unsigned threads) {
+    return table.parallel_reduce(
+        0LL, [](const auto &entry) { return (long long)entry.key; },
+        [](long long a, long long b) { return a + b; }, threads);
+  };
+  EXPECT_EQ(sum_keys(1), key_sum);
+  EXPECT_EQ(sum_keys(4), key_sum);
+
+  OpenAddressingHashTable<int, long long, Hash<int>> copy = table;
+  EXPECT_TRUE(copy == table);
+  copy[299999] = 0;
+  EXPECT_TRUE(copy != table);
+  copy[299999] = table.at(299999);
+  copy[1] = 0;
+  EXPECT_TRUE(copy != table);
+  copy[1] = table.at(1);
+  EXPECT_TRUE(copy == table);
+  copy.erase(299999);
+  copy.insert(300001, 0);
+  EXPECT_TRUE(copy != table);
+
+  OpenAddressingHashTable<int, NoValue, Hash<int>> keys;
+  for (int i = 0; i < 200000; ++i)
+    keys.try_emplace(i);
+  EXPECT_EQ(keys.parallel_reduce(
+                size_t(0), [](const auto &) { return size_t(1); },
+                [](size_t a, size_t b) { return a + b; }, 3),
+            keys.size());
+}
+
+#if __has_include(<sys/mman.h>)
+TEST(OpenAddressingHashTableTest, SnapshotSaveAndMap) {
+  const std::string path = testing::TempDir() + "oaht_snapshot.bin";
+  OpenAddressingHashTable<int, int, Hash<int>> table;
+  for (int i = 0; i < 50000; ++i)
+    table.insert(i * 3, i);
+  for (int i = 0; i < 50000; i += 5)
+    table.erase(i * 3);
+  table.save(path);
+
+  auto mapped = OpenAddressingHashTable<int, int, Hash<int>>::map(path);
+  EXPECT_EQ(mapped.size(), table.size());
+  EXPECT_EQ(mapped.bucket_count(), table.bucket_count());
+  for (int i = 0; i < 50000; ++i) {
+    const int *value = mapped.find(i * 3);
+    if (i % 5 == 0) {
+      ASSERT_EQ(value, nullptr);
+    } else {
+      ASSERT_NE(value, nullptr);
+      ASSERT_EQ(*value, i);
+    }
+  }
+  EXPECT_FALSE(mapped.contains(1));
+  EXPECT_THROW(mapped.at(1), std::out_of_range);
+
+  // The header records the policy and hash; a mismatched table refuses it.
+  using Quadratic =
+      OpenAddressingHashTable<int, int, Hash<int>, QuadraticHashing<int>>;
+  EXPECT_THROW(Quadratic::map(path), std::runtime_error);
+  using Stored = OpenAddressingHashTable<int, int, StoreHash<Hash<int>>,
+                                         DoubleHashing<int>>;
+  EXPECT_THROW(Stored::map(path), std::runtime_error);
+
+  Stored stored;
+  for (int i = 0; i < 1000; ++i)
+    stored.insert(i, -i);
+  stored.save(path);
+  auto mapped_stored = Stored::map(path);
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_EQ(mapped_stored.at(i), -i);
+
+  std::ofstream(path, std::ios::trunc) << "not a snapshot";
+  EXPECT_THROW(Stored::map(path), std::runtime_error);
+  EXPECT_THROW(Stored::map(path + ".missing"), std::runtime_error);
+  std::remove(path.c_str());
+}
+#endif
+
+static std::vector<StringHashImplementation> string_hash_implementations() {
+  std::vector<StringHashImplementation> implementations = {
+      {"portable", portable_string_hash}};
+#ifdef HASH_TABLE_X86_DISPATCH
+  if (__builtin_cpu_supports("aes"))
+    implementations.push_back({"aes", aes_string_hash});
+  if (__builtin_cpu_supports("sse4.2"))
+    implementations.push_back({"crc32c", crc32c_string_hash});
+#endif
+  return implementations;
+}
+
+TEST(OpenAddressingHashTableTest, AcceleratedStringHashImplementations) {
+  uint64_t state = 12345;
+  std::string bytes(4096, '\0');
+  for (char &c : bytes) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    c = static_cast<char>(state >> 56);
+  }
+
+  for (const auto &implementation : string_hash_implementations()) {
+    SCOPED_TRACE(implementation.name);
+    // Distinct keys of every length get distinct hashes, and the low bits used
+    // for the slot index are spread evenly.
+    std::unordered_set<std::string_view> distinct;
+    std::unordered_set<size_t> seen;
+    std::vector<int> buckets(64, 0);
+    size_t keys = 0;
+    for (size_t size = 0; size <= 300; ++size) {
+      for (size_t offset = 0; offset < 64; ++offset, ++keys) {
+        size_t hash = implementation.hash(bytes.data() + offset, size);
+        distinct.insert(std::string_view(bytes.data() + offset, size));
+        seen.insert(hash);
+        ++buckets[hash & 63];
+      }
+    }
+    EXPECT_EQ(seen.size(), distinct.size());
+    for (int count : buckets)
+      EXPECT_NEAR(count, double(keys) / 64, double(keys) / 64 * 0.25);
+
+    // Flipping any bit of any byte changes the hash.
+    std::string key = bytes.substr(0, 200);
+    size_t original = implementation.hash(key.data(), key.size());
+    for (size_t i = 0; i < key.size(); ++i) {
+      for (int bit = 0; bit < 8; ++bit) {
+        key[i] ^= static_cast<char>(1 << bit);
+        EXPECT_NE(implementation.hash(key.data(), key.size()), original);
+        key[i] ^= static_cast<char>(1 << bit);
+      }
+    }
+  }
+
+  OpenAddressingHashTable<std::string, int, AcceleratedStringHash> table;
+  for (int i = 0; i < 5000; ++i)
+    table.insert("https://example.com/static/assets/" + std::to_string(i), i);
+  for (int i = 0; i < 5000; ++i)
+    ASSERT_EQ(table.at("https://example.com/static/assets/" +
+                       std::to_string(i)),
+              i);
+  EXPECT_FALSE(table.contains(std::string_view("https://example.com/")));
+}
+
+TEST(OpenAddressingHashTableTest, IndexMixes) {
+  static_assert(is_linear_probing<LinearHashing<int, FibonacciMix>>::value);
+  static_assert(LinearHashing<int, FinalizerMix>::snapshot_id !=
+                LinearHashing<int>::snapshot_id);
+
+  // Hash<int> keeps the stride's factors of two in the low bits, so these
+  // keys share 1/4096 of the home slots without a mix.
+  FibonacciMix fibonacci;
+  FinalizerMix finalizer;
+  std::unordered_set<size_t> identity_homes, fibonacci_homes, finalizer_homes;
+  for (int i = 0; i < 4096; ++i) {
+    size_t hash = Hash<int>()(i << 12);
+    identity_homes.insert(hash & 8191);
+    fibonacci_homes.insert(fibonacci(hash) & 8191);
+    finalizer_homes.insert(finalizer(hash) & 8191);
+  }
+  EXPECT_EQ(identity_homes.size(), 2u);
+  EXPECT_GT(fibonacci_homes.size(), 2500u);
+  EXPECT_GT(finalizer_homes.size(), 2500u);
+
+  OpenAddressingHashTable<int, int, Hash<int>, LinearHashing<int, FibonacciMix>>
+      linear;
+  OpenAddressingHashTable<int, int, Hash<int>,
+                          DoubleHashing<int, FinalizerMix>>
+      double_hashed;
+  for (int i = 0; i < 20000; ++i) {
+    linear.insert(i << 12, i);
+    double_hashed.insert(i << 12, i);
+  }
+  for (int i = 0; i < 20000; i += 2) {
+    linear.erase(i << 12);
+    double_hashed.erase(i << 12);
+  }
+  for (int i = 0; i < 20000; ++i) {
+    ASSERT_EQ(linear.contains(i << 12), i % 2 == 1);
+    ASSERT_EQ(double_hashed.contains(i << 12), i % 2 == 1);
+  }
+}
+
+TEST(OpenAddressingHashTableTest, MaxLoadFactorAndShrinkToFit) {
+  OpenAddressingHashTable<int, int> dense, sparse;
+  dense.max_load_factor(0.875f);
+  sparse.max_load_factor(0.5f);
+  for (int i = 0; i < 7000; ++i) {
+    dense.insert(i, i);
+    sparse.insert(i, i);
+  }
+  EXPECT_EQ(dense.bucket_count(), 8192u);
+  EXPECT_EQ(sparse.bucket_count(), 16384u);
+  EXPECT_LE(dense.load_factor(), 0.875f);
+  EXPECT_LE(sparse.load_factor(), 0.5f);
+  EXPECT_THROW(dense.max_load_factor(1.0f), std::invalid_argument);
+  EXPECT_THROW(dense.max_tombstone_factor(0.0f), std::invalid_argument);
+
+  // Lowering the limit below the current load rehashes immediately.
+  dense.max_load_factor(0.5f);
+  EXPECT_EQ(dense.bucket_count(), 16384u);
+
+  OpenAddressingHashTable<int, int> copy = sparse;
+  EXPECT_EQ(copy.max_load_factor(), 0.5f);
+
+  for (int i = 0; i < 6900; ++i)
+    sparse.erase(i);
+  sparse.shrink_to_fit();
+  EXPECT_EQ(sparse.bucket_count(), 256u);
+  for (int i = 6900; i < 7000; ++i)
+    ASSERT_EQ(sparse.at(i), i);
+
+  // Draining by erase alone shrinks too, at the tombstone sweeps.
+  OpenAddressingHashTable<int, int> drained;
+  for (int i = 0; i < 10000; ++i)
+    drained.insert(i, i);
+  for (int i = 0; i < 10000; ++i)
+    drained.erase(i);
+  EXPECT_LE(drained.bucket_count(), 1024u);
+
+  dense.clear();
+  EXPECT_EQ(dense.bucket_count(), 16384u);
+  dense.shrink_to_fit();
+  EXPECT_EQ(dense.bucket_count(), 4u);
+  dense.insert(1, 1);
+  EXPECT_TRUE(dense.contains(1));
+}
+
+template <typename GrowthPolicy> void check_growth_policy() {
+  OpenAddressingHashTable<std::string, int, StoreHash<Hash<std::string>>,
+                          LinearHashing<std::string>,
+                          std::allocator<Entry<std::string, int>>,
+                          GrowthPolicy>
+      table;
+  for (int i = 0; i < 20000; ++i)
+    table.insert("key_" + std::to_string(i), i);
+  EXPECT_LE(table.load_factor(), LOAD_FACTOR);
+  for (int i = 0; i < 20000; i += 3)
+    table.erase("key_" + std::to_string(i));
+  for (int i = 0; i < 20000; ++i) {
+    auto it = table.find("key_" + std::to_string(i));
+    ASSERT_EQ(it != table.end(), i % 3 != 0);
+  }
+  table.shrink_to_fit();
+  EXPECT_EQ(table.size(), 13333u);
+  for (int i = 1; i < 20000; i += 3)
+    ASSERT_EQ(table.at("key_" + std::to_string(i)), i);
+}
+
+TEST(OpenAddressingHashTableTest, GrowthPolicies) {
+  check_growth_policy<DoublingGrowth>();
+  check_growth_policy<OneAndHalfGrowth>();
+  check_growth_policy<FixedStepGrowth<1000>>();
+
+  using Table = OpenAddressingHashTable<int, int, Hash<int>, LinearHashing<int>,
+                                        std::allocator<Entry<int, int>>,
+                                        OneAndHalfGrowth>;
+  Table table;
+  std::vector<size_t> capacities;
+  for (int i = 0; i < 1000; ++i) {
+    table.insert(i, i);
+    if (capacities.empty() || capacities.back() != table.bucket_count())
+      capacities.push_back(table.bucket_count());
+  }
+  for (size_t i = 1; i < capacities.size(); ++i)
+    EXPECT_EQ(capacities[i], capacities[i - 1] + capacities[i - 1] / 2);
+
+#if __has_include(<sys/mman.h>)
+  const std::string path = testing::TempDir() + "oaht_growth_snapshot.bin";
+  table.save(path);
+  auto mapped = Table::map(path);
+  EXPECT_EQ(mapped.bucket_count(), table.bucket_count());
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_EQ(mapped.at(i), i);
+  std::remove(path.c_str());
+#endif
+}
+
+TEST(OpenAddressingHashTableTest, Telemetry) {
+  HashTableTelemetry telemetry(1);
+  OpenAddressingHashTable<int, int> table;
+  table.insert(-1, -1);
+  EXPECT_EQ(telemetry.snapshot().insert.samples, 0u);
+
+  table.set_telemetry(&telemetry);
+  EXPECT_EQ(table.get_telemetry(), &telemetry);
+  for (int i = 0; i < 1000; ++i)
+    table.insert(i, i);
+  TelemetrySnapshot snapshot = table.telemetry_snapshot();
+  EXPECT_EQ(snapshot.insert.samples, 1000u);
+  EXPECT_GE(snapshot.insert.total_probes, 1000u);
+  EXPECT_GT(snapshot.rehashes, 0u);
+  EXPECT_GE(snapshot.rehash_total_ns, snapshot.rehash_max_ns);
+  EXPECT_EQ(snapshot.size, 1001u);
+  EXPECT_EQ(snapshot.capacity, table.bucket_count());
+  EXPECT_FLOAT_EQ(snapshot.load_factor, table.load_factor());
+
+  telemetry.reset();
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_TRUE(table.contains(i));
+  for (int i = 1000; i < 1500; ++i)
+    ASSERT_FALSE(table.contains(i));
+  snapshot = table.telemetry_snapshot();
+  EXPECT_EQ(snapshot.find_hit.samples, 1000u);
+  EXPECT_EQ(snapshot.find_miss.samples, 500u);
+  EXPECT_EQ(snapshot.insert.samples, 0u);
+  EXPECT_EQ(snapshot.rehashes, 0u);
+  uint64_t bucketed = 0;
+  for (uint64_t count : snapshot.find_hit.counts)
+    bucketed += count;
+  EXPECT_EQ(bucketed, 1000u);
+  EXPECT_GE(snapshot.find_hit.mean(), 1.0);
+  EXPECT_LE(snapshot.find_hit.quantile(0.5),
+            snapshot.find_hit.quantile(0.99));
+  EXPECT_LE(snapshot.find_hit.quantile(0.99), snapshot.find_hit.max_probes);
+
+  for (int i = 0; i < 100; ++i)
+    table.erase(i);
+  snapshot = table.telemetry_snapshot();
+  EXPECT_EQ(snapshot.tombstones, table.num_deleted);
+  EXPECT_GT(snapshot.tombstone_ratio, 0.0f);
+
+  // A constant hash makes insert i skip the i keys before it.
+  struct ConstantHash {
+    size_t operator()(int) const { return 0; }
+  };
+  OpenAddressingHashTable<int, int, ConstantHash> colliding;
+  colliding.set_telemetry(&telemetry);
+  telemetry.reset();
+  for (int i = 0; i < 64; ++i)
+    colliding.insert(i, i);
+  snapshot = telemetry.snapshot();
+  EXPECT_EQ(snapshot.insert.max_probes, 64u);
+  EXPECT_EQ(snapshot.insert.total_probes, 64u * 65 / 2);
+
+  // Shared between tables, detached again, and every 8th operation sampled.
+  HashTableTelemetry sampled(8);
+  OpenAddressingHashTable<int, int> other;
+  table.set_telemetry(&sampled);
+  other.set_telemetry(&sampled);
+  for (int i = 0; i < 800; ++i) {
+    table.contains(i);
+    other.contains(i);
+  }
+  table.set_telemetry(nullptr);
+  other.set_telemetry(nullptr);
+  for (int i = 0; i < 800; ++i)
+    table.contains(i);
+  snapshot = sampled.snapshot();
+  EXPECT_EQ(snapshot.find_hit.samples + snapshot.find_miss.samples, 200u);
+  EXPECT_EQ(table.telemetry_snapshot().find_hit.samples, 0u);
+}
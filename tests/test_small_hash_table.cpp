@@ -0,0 +1,110 @@
+#include "small_hash_table.h"
+#include <gtest/gtest.h>
+#include <map>
+
+TEST(SmallHashTableTest, InlineOperations) {
+  SmallHashTable<std::string, int, 4, Hash<std::string>> table;
+  EXPECT_TRUE(table.is_inline());
+  EXPECT_TRUE(table.empty());
+
+  EXPECT_TRUE(table.insert("one", 1).second);
+  EXPECT_TRUE(table.insert("two", 2).second);
+  EXPECT_FALSE(table.insert("one", 11).second);
+  EXPECT_EQ(table.at("one"), 1);
+  EXPECT_FALSE(table.insert_or_assign("one", 111).second);
+  EXPECT_EQ(table.at("one"), 111);
+  table["three"] = 3;
+  EXPECT_EQ(table.size(), 3u);
+  EXPECT_TRUE(table.contains("three"));
+  EXPECT_EQ(table.find("four"), table.end());
+  EXPECT_THROW(table.at("four"), std::out_of_range);
+
+  EXPECT_EQ(table.erase("one"), 1u);
+  EXPECT_EQ(table.erase("one"), 0u);
+  EXPECT_EQ(table.size(), 2u);
+  EXPECT_EQ(table.at("two"), 2);
+  EXPECT_EQ(table.at("three"), 3);
+
+  int visited = 0;
+  for (auto &entry : table)
+    visited += entry.value;
+  EXPECT_EQ(visited, 5);
+  EXPECT_TRUE(table.is_inline());
+}
+
+TEST(SmallHashTableTest, SpillAndReturn) {
+  SmallHashTable<int, int, 8, Hash<int>> table;
+  std::map<int, int> reference;
+  for (int i = 0; i < 8; ++i) {
+    table.insert(i, i * 10);
+    reference[i] = i * 10;
+  }
+  EXPECT_TRUE(table.is_inline());
+  EXPECT_EQ(table.bucket_count(), 8u);
+
+  table.insert(8, 80);
+  reference[8] = 80;
+  EXPECT_FALSE(table.is_inline());
+  for (int i = 9; i < 1000; ++i) {
+    table.insert(i, i * 10);
+    reference[i] = i * 10;
+  }
+  EXPECT_EQ(table.size(), reference.size());
+  for (auto &[key, value] : reference)
+    ASSERT_EQ(table.at(key), value);
+
+  for (int i = 5; i < 1000; ++i)
+    table.erase(i);
+  EXPECT_FALSE(table.is_inline());
+  table.shrink_to_fit();
+  EXPECT_TRUE(table.is_inline());
+  EXPECT_EQ(table.size(), 5u);
+  for (int i = 0; i < 5; ++i)
+    ASSERT_EQ(table.at(i), i * 10);
+  EXPECT_FALSE(table.contains(5));
+
+  table.reserve(100);
+  EXPECT_FALSE(table.is_inline());
+  EXPECT_GE(table.bucket_count(), 100u);
+  EXPECT_EQ(table.at(4), 40);
+  table.clear();
+  EXPECT_TRUE(table.is_inline());
+  EXPECT_TRUE(table.empty());
+}
+
+TEST(SmallHashTableTest, CopyAndMove) {
+  SmallHashTable<std::string, std::string, 2, Hash<std::string>> small;
+  small.insert("a", "alpha");
+  SmallHashTable<std::string, std::string, 2, Hash<std::string>> large;
+  for (int i = 0; i < 10; ++i)
+    large.insert(std::to_string(i), std::string(20, char('a' + i)));
+
+  auto small_copy = small;
+  auto large_copy = large;
+  EXPECT_TRUE(small_copy.is_inline());
+  EXPECT_EQ(small_copy.at("a"), "alpha");
+  EXPECT_EQ(large_copy.size(), 10u);
+  large_copy.erase("0");
+  EXPECT_TRUE(large.contains("0"));
+
+  auto moved = std::move(large);
+  EXPECT_EQ(moved.size(), 10u);
+  EXPECT_TRUE(large.empty());
+  moved = std::move(small);
+  EXPECT_TRUE(moved.is_inline());
+  EXPECT_EQ(moved.at("a"), "alpha");
+  EXPECT_TRUE(small.empty());
+}
+
+TEST(SmallHashTableTest, MoveOnlyValues) {
+  SmallHashTable<int, std::unique_ptr<int>, 2, Hash<int>> table;
+  for (int i = 0; i < 5; ++i)
+    table.try_emplace(i, std::make_unique<int>(i));
+  for (int i = 0; i < 5; ++i)
+    ASSERT_EQ(*table.at(i), i);
+  for (int i = 2; i < 5; ++i)
+    table.erase(i);
+  table.shrink_to_fit();
+  EXPECT_TRUE(table.is_inline());
+  EXPECT_EQ(*table.at(1), 1);
+}